@@ -0,0 +1,600 @@
+// Бенчмарки контейнеров. Запуск: make bench или ./bench_runner [имя_раздела]
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../libs/hash_table.h"
+#include "../libs/flat_hash_table.h"
+#include "../libs/concurrent_hash_table.h"
+#include "../libs/mapped_hash_table.h"
+#include "../libs/durable_hash_table.h"
+#include "../libs/frozen_hash_table.h"
+#include "../libs/massive.h"
+#include "../libs/packed_str_array.h"
+#include "../libs/gap_str_array.h"
+#include "../libs/segmented_str_array.h"
+#include <mutex>
+#include <thread>
+
+using Clock = chrono::steady_clock;
+
+static double nsSince(Clock::time_point start) {
+    return chrono::duration<double, nano>(Clock::now() - start).count();
+}
+
+static double percentile(vector<double>& samples, double p) {
+    size_t idx = static_cast<size_t>(p * (samples.size() - 1));
+    nth_element(samples.begin(), samples.begin() + idx, samples.end());
+    return samples[idx];
+}
+
+static vector<string> makeKeys(size_t n, const string& prefix = "user:") {
+    vector<string> keys;
+    keys.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys.push_back(prefix + to_string(i));
+    }
+    return keys;
+}
+
+// Задержка push во время роста: обычный и постепенный рехеш
+static void benchRehash() {
+    const size_t n = 2000000;
+    vector<string> keys = makeKeys(n);
+    for (int mode = 0; mode < 2; ++mode) {
+        HashTable table;
+        table.setIncrementalRehash(mode == 1, 4);
+        vector<double> samples;
+        samples.reserve(n);
+        auto total = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            auto start = Clock::now();
+            table.push(keys[i], "value");
+            samples.push_back(nsSince(start));
+        }
+        double totalMs = nsSince(total) / 1e6;
+        double maxNs = *max_element(samples.begin(), samples.end());
+        cout << (mode == 0 ? "rehash/stop-the-world" : "rehash/incremental   ")
+             << fixed << setprecision(1)
+             << "  total " << totalMs << " ms"
+             << "  p50 " << percentile(samples, 0.50) << " ns"
+             << "  p99 " << percentile(samples, 0.99) << " ns"
+             << "  p99.99 " << percentile(samples, 0.9999) << " ns"
+             << "  max " << maxNs / 1e3 << " us" << endl;
+    }
+}
+
+// Вставка, успешный и неуспешный поиск: цепочки против открытой адресации
+template <typename Table>
+static void benchTable(const string& name, const vector<string>& keys, const vector<string>& missing) {
+    Table table;
+    auto start = Clock::now();
+    for (const string& key : keys) {
+        table.push(key, "value");
+    }
+    double pushNs = nsSince(start) / keys.size();
+    string result;
+    size_t found = 0;
+    start = Clock::now();
+    for (const string& key : keys) {
+        found += table.get(key, result);
+    }
+    double hitNs = nsSince(start) / keys.size();
+    start = Clock::now();
+    for (const string& key : missing) {
+        found += table.get(key, result);
+    }
+    double missNs = nsSince(start) / missing.size();
+    start = Clock::now();
+    for (const string& key : keys) {
+        table.del(key);
+    }
+    double delNs = nsSince(start) / keys.size();
+    cout << name << fixed << setprecision(1)
+         << "  push " << pushNs << " ns  get-hit " << hitNs << " ns  get-miss " << missNs
+         << " ns  del " << delNs << " ns  (found " << found << ")" << endl;
+}
+
+static void benchBackends() {
+    const size_t n = 1000000;
+    vector<string> keys = makeKeys(n);
+    vector<string> missing = makeKeys(n, "absent:");
+    // Случайный порядок, иначе последовательные ключи дают кэшу лишнюю локальность
+    mt19937_64 rng(42);
+    shuffle(keys.begin(), keys.end(), rng);
+    shuffle(missing.begin(), missing.end(), rng);
+    benchTable<HashTable>("backend/chained", keys, missing);
+    benchTable<FlatHashTable>("backend/flat   ", keys, missing);
+}
+
+// Одна глобальная блокировка вокруг HashTable - то, что заменяет ConcurrentHashTable
+class GlobalLockTable {
+private:
+    mutex lock;
+    HashTable table;
+
+public:
+    void push(string_view key, string_view value) {
+        lock_guard<mutex> guard(lock);
+        table.push(key, value);
+    }
+
+    bool get(string_view key, string& result) {
+        lock_guard<mutex> guard(lock);
+        return table.get(key, result);
+    }
+
+    bool del(string_view key) {
+        lock_guard<mutex> guard(lock);
+        return table.del(key);
+    }
+};
+
+// Пропускная способность (Mops/s) при 90% get / 5% push / 5% del
+template <typename Table>
+static double runThreads(const vector<string>& keys, size_t threads) {
+    const size_t opsPerThread = 500000;
+    Table table;
+    for (size_t i = 0; i < keys.size(); i += 2) {
+        table.push(keys[i], "value");
+    }
+    vector<thread> workers;
+    auto start = Clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            mt19937_64 rng(t);
+            string result;
+            for (size_t i = 0; i < opsPerThread; ++i) {
+                uint64_t r = rng();
+                const string& key = keys[r % keys.size()];
+                unsigned op = (r >> 40) % 20;
+                if (op == 0) {
+                    table.push(key, "value");
+                } else if (op == 1) {
+                    table.del(key);
+                } else {
+                    table.get(key, result);
+                }
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    return threads * opsPerThread / (nsSince(start) / 1e9) / 1e6;
+}
+
+// Масштабирование от 1 до N потоков: глобальный мьютекс против полос
+static void benchConcurrent() {
+    vector<string> keys = makeKeys(200000);
+    size_t maxThreads = max<size_t>(thread::hardware_concurrency(), 4);
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        // push существующего ключа печатает ошибку, здесь это ожидаемо
+        streambuf* saved = cout.rdbuf(nullptr);
+        double global = runThreads<GlobalLockTable>(keys, threads);
+        double striped = runThreads<ConcurrentHashTable>(keys, threads);
+        cout.rdbuf(saved);
+        cout << "concurrent threads " << setw(2) << threads << fixed << setprecision(2)
+             << "  global-mutex " << global << " Mops/s  striped " << striped << " Mops/s" << endl;
+    }
+}
+
+// Холодный старт: разбор бинарного файла против отображения снимка
+static void benchSnapshot() {
+    const size_t n = 2000000;
+    vector<string> keys = makeKeys(n);
+    {
+        HashTable table;
+        for (const string& key : keys) {
+            table.push(key, "value:" + key);
+        }
+        table.saveToBinaryFile("bench_table.bin");
+        table.saveSnapshot("bench_snapshot.bin");
+    }
+    string result;
+    auto start = Clock::now();
+    {
+        HashTable loaded;
+        loaded.loadFromBinaryFile("bench_table.bin");
+        loaded.get(keys[n / 2], result);
+        cout << "snapshot/loadFromBinaryFile  " << fixed << setprecision(2) << nsSince(start) / 1e6
+             << " ms to first get" << endl;
+    }
+    start = Clock::now();
+    {
+        HashTable loaded;
+        loaded.loadFromBinaryFile("bench_table.bin", true);
+        loaded.get(keys[n / 2], result);
+        cout << "snapshot/trusted bulk load   " << fixed << setprecision(2) << nsSince(start) / 1e6
+             << " ms to first get" << endl;
+    }
+    start = Clock::now();
+    MappedHashTable mapped;
+    mapped.open("bench_snapshot.bin");
+    mapped.get(keys[n / 2], result);
+    cout << "snapshot/MappedHashTable     " << fixed << setprecision(2) << nsSince(start) / 1e6
+         << " ms to first get" << endl;
+    fs::remove("bench_table.bin");
+    fs::remove("bench_snapshot.bin");
+}
+
+// Пакетный поиск с предвыборкой против get в цикле на таблице больше L3
+static void benchMultiGet() {
+    const size_t n = 6000000;
+    const size_t batch = 500;
+    vector<string> keys = makeKeys(n);
+    HashTable table;
+    table.reserve(n);
+    for (const string& key : keys) {
+        table.push(key, "value");
+    }
+    mt19937_64 rng(7);
+    vector<string_view> lookups(2000000);
+    for (string_view& key : lookups) {
+        key = keys[rng() % n];
+    }
+    size_t found = 0;
+    string_view value;
+    auto start = Clock::now();
+    for (string_view key : lookups) {
+        found += table.get(key, value);
+    }
+    double singleNs = nsSince(start) / lookups.size();
+    vector<string_view> values(batch);
+    unique_ptr<bool[]> hits(new bool[batch]);
+    start = Clock::now();
+    for (size_t i = 0; i < lookups.size(); i += batch) {
+        found += table.multiGet(lookups.data() + i, min(batch, lookups.size() - i), values.data(), hits.get());
+    }
+    double batchNs = nsSince(start) / lookups.size();
+    cout << "multiget/" << n << " keys, batches of " << batch << fixed << setprecision(1)
+         << "  get loop " << singleNs << " ns/key  multiGet " << batchNs << " ns/key"
+         << "  (found " << found << ")" << endl;
+}
+
+// Поиск с 70% промахов: без фильтра промах проходит всю цепочку
+// (а при заполненной таблице - корзину и узлы), с фильтром - одну линию
+static void benchBloom() {
+    const size_t n = 4000000;
+    vector<string> keys = makeKeys(n);
+    vector<string> missing = makeKeys(n, "miss:");
+    mt19937_64 rng(11);
+    vector<string_view> lookups(2000000);
+    for (string_view& key : lookups) {
+        key = rng() % 10 < 7 ? string_view(missing[rng() % n]) : string_view(keys[rng() % n]);
+    }
+    for (int withBloom = 0; withBloom < 2; ++withBloom) {
+        HashTable table;
+        table.reserve(n);
+        if (withBloom) {
+            table.enableBloomFilter(n);
+        }
+        for (const string& key : keys) {
+            table.push(key, "value");
+        }
+        size_t found = 0;
+        string_view value;
+        auto start = Clock::now();
+        for (string_view key : lookups) {
+            found += table.get(key, value);
+        }
+        double ns = nsSince(start) / lookups.size();
+        cout << "bloom/" << n << " keys, 70% misses  " << (withBloom ? "with filter   " : "without filter")
+             << fixed << setprecision(1) << "  " << ns << " ns/lookup  (found " << found << ")" << endl;
+    }
+}
+
+// Групповая фиксация: сколько fsync приходится на изменения при
+// разном числе пишущих потоков
+static void benchWal() {
+    const size_t perThread = 2000;
+    for (size_t threads : {1, 4, 16}) {
+        for (const char* suffix : {".snap", ".wal", ".wal.old"}) {
+            fs::remove(string("bench_wal") + suffix);
+        }
+        DurableHashTable table;
+        table.open("bench_wal");
+        auto start = Clock::now();
+        vector<thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&table, t, perThread]() {
+                for (size_t i = 0; i < perThread; ++i) {
+                    table.push("key" + to_string(t) + "_" + to_string(i), "value");
+                }
+            });
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+        double seconds = nsSince(start) / 1e9;
+        size_t ops = threads * perThread;
+        cout << "wal/" << threads << " threads  " << fixed << setprecision(0) << ops / seconds << " ops/s  "
+             << table.getSyncCount() << " fsyncs for " << ops << " ops" << endl;
+        table.close();
+    }
+    for (const char* suffix : {".snap", ".wal", ".wal.old"}) {
+        fs::remove(string("bench_wal") + suffix);
+    }
+}
+
+// Загрузка текстового файла: построчное чтение getline + push,
+// прежняя загрузка одним пакетом (весь файл, find, pushBatch) и
+// новый загрузчик с отображением файла и разбором SSE2
+static void benchLoad() {
+    const size_t n = 3000000;
+    vector<string> keys = makeKeys(n);
+    {
+        ofstream file("bench_load.txt");
+        for (size_t i = 0; i < n; ++i) {
+            file << keys[i] << ";value" << i << "\n";
+        }
+    }
+    auto start = Clock::now();
+    {
+        HashTable table;
+        ifstream file("bench_load.txt");
+        string line;
+        while (getline(file, line)) {
+            size_t pos = line.find(';');
+            if (pos != string::npos) {
+                table.push(line.substr(0, pos), line.substr(pos + 1));
+            }
+        }
+    }
+    double getlineMs = nsSince(start) / 1e6;
+    start = Clock::now();
+    {
+        HashTable table;
+        ifstream file("bench_load.txt", ios::binary);
+        string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        vector<pair<string_view, string_view>> records;
+        string_view rest(content);
+        while (!rest.empty()) {
+            size_t end = rest.find('\n');
+            string_view line = rest.substr(0, end);
+            rest = end == string_view::npos ? string_view() : rest.substr(end + 1);
+            size_t pos = line.find(';');
+            if (pos != string_view::npos) {
+                records.emplace_back(line.substr(0, pos), line.substr(pos + 1));
+            }
+        }
+        table.pushBatch(records);
+    }
+    double batchMs = nsSince(start) / 1e6;
+    cout << "load/" << n << " lines  " << fixed << setprecision(0) << "getline+push " << getlineMs
+         << " ms  find+pushBatch " << batchMs << " ms";
+    for (size_t threads : {1, 4}) {
+        start = Clock::now();
+        HashTable table;
+        table.loadFromFile("bench_load.txt", false, threads);
+        cout << "  loadFromFile/" << threads << " " << nsSince(start) / 1e6 << " ms";
+    }
+    cout << "  (" << thread::hardware_concurrency() << " cores)" << endl;
+    fs::remove("bench_load.txt");
+}
+
+// Текстовая выгрузка: ofstream с endl на каждой записи против TextExporter
+static void benchExport() {
+    const size_t n = 2000000;
+    vector<string> keys = makeKeys(n);
+    HashTable table;
+    table.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        table.push(keys[i], "value" + to_string(i));
+    }
+    auto start = Clock::now();
+    {
+        ofstream file("bench_export.txt");
+        for (const string& key : keys) {
+            string_view value;
+            table.get(key, value);
+            file << key << ";" << value << endl;
+        }
+    }
+    double streamMs = nsSince(start) / 1e6;
+    start = Clock::now();
+    table.saveToFile("bench_export.txt");
+    double exporterMs = nsSince(start) / 1e6;
+    cout << "export/" << n << " pairs  " << fixed << setprecision(0) << "ofstream+endl " << streamMs
+         << " ms  saveToFile " << exporterMs << " ms" << endl;
+    fs::remove("bench_export.txt");
+}
+
+// Замороженная таблица: время построения, объём и задержка get
+// (среднее и p99 по пакетам) против HashTable
+static void benchFrozen() {
+    const size_t n = 4000000;
+    vector<string> keys = makeKeys(n);
+    HashTable table;
+    table.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        table.push(keys[i], "value");
+    }
+    auto start = Clock::now();
+    FrozenHashTable frozen;
+    frozen.build(table);
+    double buildMs = nsSince(start) / 1e6;
+    mt19937_64 rng(5);
+    vector<string_view> lookups(2000000);
+    for (string_view& key : lookups) {
+        key = keys[rng() % n];
+    }
+    auto measure = [&](auto& target) {
+        vector<double> samples;
+        string_view value;
+        size_t found = 0;
+        for (size_t i = 0; i < lookups.size(); i += 1000) {
+            auto batchStart = Clock::now();
+            for (size_t j = i; j < i + 1000; ++j) {
+                found += target.get(lookups[j], value);
+            }
+            samples.push_back(nsSince(batchStart) / 1000);
+        }
+        double mean = 0;
+        for (double sample : samples) {
+            mean += sample / samples.size();
+        }
+        cout << fixed << setprecision(1) << mean << " ns mean, " << percentile(samples, 0.99) << " ns p99  (found "
+             << found << ")";
+        return found;
+    };
+    size_t chainedBytes = n * 64 + table.getCapacity() * sizeof(void*);
+    cout << "frozen/" << n << " keys  build " << fixed << setprecision(0) << buildMs << " ms  HashTable ~"
+         << chainedBytes / (1 << 20) << " MB, frozen " << frozen.getMemoryUsage() / (1 << 20) << " MB" << endl;
+    cout << "  HashTable get ";
+    measure(table);
+    cout << endl << "  Frozen get    ";
+    measure(frozen);
+    cout << endl;
+}
+
+// Снимок с копированием при записи: стоимость snapshot() и
+// скорость push/del, пока другой поток сохраняет снимок
+static void benchCow() {
+    const size_t n = 2000000;
+    const size_t ops = 1000000;
+    vector<string> keys = makeKeys(n);
+    vector<string> extra = makeKeys(ops, "extra:");
+    for (int withSnapshot = 0; withSnapshot < 2; ++withSnapshot) {
+        HashTable table;
+        table.reserve(n + ops);
+        for (const string& key : keys) {
+            table.push(key, "value");
+        }
+        auto start = Clock::now();
+        unique_ptr<HashTable::Snapshot> snapshot;
+        thread saver;
+        if (withSnapshot) {
+            snapshot = table.snapshot();
+            double snapshotUs = nsSince(start) / 1e3;
+            cout << "cow/" << n << " keys  snapshot() " << fixed << setprecision(0) << snapshotUs << " us" << endl;
+            saver = thread([&snapshot]() {
+                snapshot->saveToBinaryFile("bench_cow.bin");
+            });
+        }
+        start = Clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            table.del(keys[i]);
+            table.push(extra[i], "value");
+        }
+        double opNs = nsSince(start) / (2 * ops);
+        if (saver.joinable()) {
+            saver.join();
+        }
+        cout << "  del+push " << (withSnapshot ? "during background save" : "without snapshot      ") << "  "
+             << fixed << setprecision(1) << opNs << " ns/op" << endl;
+    }
+    fs::remove("bench_cow.bin");
+}
+
+// Массив строк: обход и сериализация StrArray против PackedStrArray
+static void benchStrArray() {
+    const size_t n = 2000000;
+    vector<string> values = makeKeys(n, "element-with-a-longer-payload:");
+    StrArray array;
+    PackedStrArray packed;
+    for (const string& value : values) {
+        array.push(value);
+        packed.push(value);
+    }
+    auto start = Clock::now();
+    size_t total = 0;
+    string item;
+    for (size_t i = 0; i < n; ++i) {
+        array.get(i, item);
+        total += item.size();
+    }
+    double arrayScanMs = nsSince(start) / 1e6;
+    start = Clock::now();
+    packed.forEach([&](string_view value) {
+        total += value.size();
+    });
+    double packedScanMs = nsSince(start) / 1e6;
+    start = Clock::now();
+    array.serialize("bench_array.bin");
+    StrArray arrayLoaded;
+    arrayLoaded.deserialize("bench_array.bin");
+    double arrayIoMs = nsSince(start) / 1e6;
+    start = Clock::now();
+    packed.serialize("bench_array.bin");
+    PackedStrArray packedLoaded;
+    packedLoaded.deserialize("bench_array.bin");
+    double packedIoMs = nsSince(start) / 1e6;
+    cout << "strarray/" << n << fixed << setprecision(0) << "  scan StrArray " << arrayScanMs << " ms  Packed "
+         << packedScanMs << " ms  serialize+deserialize StrArray " << arrayIoMs << " ms  Packed " << packedIoMs
+         << " ms  (" << total << ")" << endl;
+    fs::remove("bench_array.bin");
+}
+
+// Вставки и удаления вокруг медленно движущейся позиции у начала массива
+template <typename Array>
+static double clusteredEdits(Array& array, size_t n, size_t edits) {
+    for (size_t i = 0; i < n; ++i) {
+        array.push("element:" + to_string(i));
+    }
+    auto start = Clock::now();
+    size_t position = 1000;
+    for (size_t i = 0; i < edits; ++i) {
+        if (i % 4 == 3) {
+            array.del(position);
+        } else {
+            array.pushi(position, "inserted:" + to_string(i));
+        }
+        position += i % 16 == 0 ? 3 : 0;
+    }
+    return nsSince(start) / edits;
+}
+
+static void benchGapArray() {
+    const size_t n = 200000;
+    const size_t edits = 20000;
+    StrArray array;
+    GapStrArray gap;
+    double arrayNs = clusteredEdits(array, n, edits);
+    double gapNs = clusteredEdits(gap, n, edits);
+    cout << "gaparray/" << n << " clustered edits  " << fixed << setprecision(0) << "StrArray " << arrayNs
+         << " ns/op  GapStrArray " << gapNs << " ns/op" << endl;
+}
+
+// Худшая задержка push при росте: StrArray против блочного массива
+template <typename Array>
+static double worstPushUs(Array& array, const vector<string>& values) {
+    double worst = 0;
+    for (const string& value : values) {
+        auto start = Clock::now();
+        array.push(value);
+        worst = max(worst, nsSince(start));
+    }
+    return worst / 1000;
+}
+
+static void benchSegmented() {
+    const size_t n = 4000000;
+    vector<string> values = makeKeys(n, string(40, 'p'));
+    StrArray array;
+    SegmentedStrArray segmented;
+    double arrayUs = worstPushUs(array, values);
+    double segmentedUs = worstPushUs(segmented, values);
+    cout << "segmented/" << n << " worst push  " << fixed << setprecision(0) << "StrArray " << arrayUs
+         << " us  SegmentedStrArray " << segmentedUs << " us" << endl;
+}
+
+int main(int argc, char** argv) {
+    string only = argc > 1 ? argv[1] : "";
+    if (only.empty() || only == "rehash") benchRehash();
+    if (only.empty() || only == "backends") benchBackends();
+    if (only.empty() || only == "concurrent") benchConcurrent();
+    if (only.empty() || only == "snapshot") benchSnapshot();
+    if (only.empty() || only == "multiget") benchMultiGet();
+    if (only.empty() || only == "bloom") benchBloom();
+    if (only.empty() || only == "wal") benchWal();
+    if (only.empty() || only == "load") benchLoad();
+    if (only.empty() || only == "export") benchExport();
+    if (only.empty() || only == "frozen") benchFrozen();
+    if (only.empty() || only == "cow") benchCow();
+    if (only.empty() || only == "strarray") benchStrArray();
+    if (only.empty() || only == "gaparray") benchGapArray();
+    if (only.empty() || only == "segmented") benchSegmented();
+    return 0;
+}
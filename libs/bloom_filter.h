@@ -0,0 +1,97 @@
+#ifndef BLOOM_FILTER_H_INCLUDED
+#define BLOOM_FILTER_H_INCLUDED
+
+#include "includes.h"
+#include "hash_function.h"
+#include <cstdint>
+#include <cstring>
+
+// Блочный фильтр Блума: все биты одного ключа лежат в одном блоке
+// размером с кэш-линию, поэтому проверка читает одну линию памяти.
+// Фильтр принимает готовый 64-битный хеш ключа: блок выбирается по его
+// старшим битам, а позиции внутри блока - по перемешанному хешу.
+class BloomFilter {
+private:
+    static constexpr size_t BLOCK_WORDS = 8; // 512 бит
+    static constexpr int PROBES = 6; // бит на ключ внутри блока
+
+    uint64_t* blocks;
+    size_t blockCount;
+    size_t expectedKeys; // под сколько ключей рассчитан размер
+
+    static size_t blockIndex(uint64_t hash, size_t count) {
+        return static_cast<size_t>((static_cast<unsigned __int128>(hash) * count) >> 64);
+    }
+
+    // Для каждой из PROBES позиций берётся 9 бит перемешанного хеша
+    static bool test(const uint64_t* block, uint64_t hash) {
+        uint64_t bits = hashMix(hash, 0x9e3779b97f4a7c15ULL);
+        for (int i = 0; i < PROBES; ++i) {
+            unsigned bit = (bits >> (i * 9)) & 511;
+            if ((block[bit >> 6] & (1ULL << (bit & 63))) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    // bitsPerKey = 10 даёт около 1% ложных срабатываний
+    BloomFilter(size_t keys, size_t bitsPerKey = 10) : expectedKeys(max<size_t>(keys, 1)) {
+        blockCount = (expectedKeys * bitsPerKey + BLOCK_WORDS * 64 - 1) / (BLOCK_WORDS * 64);
+        blocks = new uint64_t[blockCount * BLOCK_WORDS];
+        clear();
+    }
+
+    ~BloomFilter() {
+        delete[] blocks;
+    }
+
+    BloomFilter(const BloomFilter&) = delete;
+    BloomFilter& operator=(const BloomFilter&) = delete;
+
+    void add(uint64_t hash) {
+        uint64_t* block = blocks + blockIndex(hash, blockCount) * BLOCK_WORDS;
+        uint64_t bits = hashMix(hash, 0x9e3779b97f4a7c15ULL);
+        for (int i = 0; i < PROBES; ++i) {
+            unsigned bit = (bits >> (i * 9)) & 511;
+            block[bit >> 6] |= 1ULL << (bit & 63);
+        }
+    }
+
+    // false - ключа точно нет, true - ключ, возможно, есть
+    bool mayContain(uint64_t hash) const {
+        return mayContain(blocks, blockCount, hash);
+    }
+
+    // Проверка по внешнему массиву блоков, например по отображённому снимку
+    static bool mayContain(const uint64_t* data, size_t count, uint64_t hash) {
+        return test(data + blockIndex(hash, count) * BLOCK_WORDS, hash);
+    }
+
+    void prefetch(uint64_t hash) const {
+        __builtin_prefetch(blocks + blockIndex(hash, blockCount) * BLOCK_WORDS);
+    }
+
+    void clear() {
+        memset(blocks, 0, blockCount * BLOCK_WORDS * sizeof(uint64_t));
+    }
+
+    const uint64_t* data() const {
+        return blocks;
+    }
+
+    size_t getBlockCount() const {
+        return blockCount;
+    }
+
+    static constexpr size_t blockBytes() {
+        return BLOCK_WORDS * sizeof(uint64_t);
+    }
+
+    size_t getExpectedKeys() const {
+        return expectedKeys;
+    }
+};
+
+#endif // BLOOM_FILTER_H_INCLUDED
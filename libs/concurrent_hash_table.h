@@ -0,0 +1,187 @@
+#ifndef CONCURRENT_HASH_TABLE_H_INCLUDED
+#define CONCURRENT_HASH_TABLE_H_INCLUDED
+
+#include "includes.h"
+#include "hash_table.h"
+#include "hash_function.h"
+#include "exporter.h"
+#include "line_scanner.h"
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+
+// Потокобезопасная хеш-таблица: ключи распределены по независимым
+// полосам (stripe), у каждой своя HashTable и свой shared_mutex.
+// Чтения одной полосы идут параллельно, а операции над ключами
+// разных полос не мешают друг другу вовсе.
+class ConcurrentHashTable {
+private:
+    // Полоса выровнена по кэш-линии, чтобы блокировки соседних полос
+    // не делили одну линию
+    class alignas(64) Stripe {
+    public:
+        mutable shared_mutex lock;
+        HashTable table;
+
+        Stripe(size_t initialCapacity) : table(initialCapacity) {}
+    };
+
+    static constexpr uint64_t STRIPE_SEED = 0x13198a2e03707344ULL;
+
+    Stripe** stripes;
+    size_t stripeCount; // степень двойки
+
+    // Полоса выбирается по младшим битам хеша с отдельным зерном,
+    // а корзина внутри HashTable - по старшим битам её собственного хеша,
+    // так что ключи одной полосы распределяются по всем её корзинам
+    static size_t stripeHash(string_view key) {
+        return fastHash(key, STRIPE_SEED);
+    }
+
+    Stripe& stripeFor(string_view key) const {
+        return *stripes[stripeHash(key) & (stripeCount - 1)];
+    }
+
+    // Обход всех пар под разделяемыми блокировками всех полос
+    template <typename Func>
+    void forEachPair(Func func) const {
+        for (size_t i = 0; i < stripeCount; ++i) {
+            stripes[i]->lock.lock_shared();
+        }
+        for (size_t i = 0; i < stripeCount; ++i) {
+            stripes[i]->table.forEachPair(func);
+        }
+        for (size_t i = 0; i < stripeCount; ++i) {
+            stripes[i]->lock.unlock_shared();
+        }
+    }
+
+public:
+    ConcurrentHashTable(size_t stripesHint = 64, size_t initialCapacity = 10) {
+        stripeCount = 1;
+        while (stripeCount < stripesHint) {
+            stripeCount *= 2;
+        }
+        stripes = new Stripe*[stripeCount];
+        for (size_t i = 0; i < stripeCount; ++i) {
+            stripes[i] = new Stripe(initialCapacity);
+        }
+    }
+
+    ~ConcurrentHashTable() {
+        for (size_t i = 0; i < stripeCount; ++i) {
+            delete stripes[i];
+        }
+        delete[] stripes;
+    }
+
+    ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+    ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
+
+    void push(string_view key, string_view value) {
+        Stripe& stripe = stripeFor(key);
+        unique_lock<shared_mutex> guard(stripe.lock);
+        stripe.table.push(key, value);
+    }
+
+    // Значение всегда копируется: ссылка внутрь таблицы могла бы
+    // пережить удаление ключа другим потоком
+    bool get(string_view key, string& result) const {
+        Stripe& stripe = stripeFor(key);
+        shared_lock<shared_mutex> guard(stripe.lock);
+        return stripe.table.get(key, result);
+    }
+
+    bool del(string_view key) {
+        Stripe& stripe = stripeFor(key);
+        unique_lock<shared_mutex> guard(stripe.lock);
+        return stripe.table.del(key);
+    }
+
+    // Сохранение в текстовый файл
+    void saveToFile(const string& filename) const {
+        TextExporter file(filename);
+        if (!file.isOpen()) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        forEachPair([&](const auto* current) {
+            file.writeField(current->key());
+            file.write(';');
+            file.writeField(current->value());
+            file.write('\n');
+        });
+        if (!file.close()) {
+            cerr << "Error writing file." << endl;
+        }
+    }
+
+    // Загрузка из текстового файла
+    void loadFromFile(const string& filename) {
+        ifstream file(filename, ios::binary);
+        string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        LineScanner scanner(content.data(), content.data() + content.size());
+        string_view key, value;
+        while (scanner.next(key, value)) {
+            push(key, value);
+        }
+    }
+
+    // Сохранение в бинарный файл
+    void saveToBinaryFile(const string& filename) const {
+        ofstream file(filename, ios::binary);
+        forEachPair([&](const auto* current) {
+            size_t keySize = current->keySize;
+            size_t valueSize = current->valueSize;
+            file.write(reinterpret_cast<char*>(&keySize), sizeof(keySize));
+            file.write(current->data(), keySize);
+            file.write(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
+            file.write(current->data() + keySize, valueSize);
+        });
+        file.close();
+    }
+
+    // Загрузка из бинарного файла
+    void loadFromBinaryFile(const string& filename) {
+        ifstream file(filename, ios::binary);
+        while (file) {
+            size_t keySize, valueSize;
+            if (!file.read(reinterpret_cast<char*>(&keySize), sizeof(keySize))) break;
+
+            string key(keySize, '\0');
+            file.read(&key[0], keySize);
+
+            file.read(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
+            string value(valueSize, '\0');
+            file.read(&value[0], valueSize);
+
+            push(key, value);
+        }
+        file.close();
+    }
+
+    // Суммарная ёмкость всех полос
+    size_t getCapacity() const {
+        size_t total = 0;
+        for (size_t i = 0; i < stripeCount; ++i) {
+            shared_lock<shared_mutex> guard(stripes[i]->lock);
+            total += stripes[i]->table.getCapacity();
+        }
+        return total;
+    }
+
+    size_t getSize() const {
+        size_t total = 0;
+        for (size_t i = 0; i < stripeCount; ++i) {
+            shared_lock<shared_mutex> guard(stripes[i]->lock);
+            total += stripes[i]->table.getSize();
+        }
+        return total;
+    }
+
+    size_t getStripeCount() const {
+        return stripeCount;
+    }
+};
+
+#endif // CONCURRENT_HASH_TABLE_H_INCLUDED
@@ -0,0 +1,470 @@
+#ifndef DURABLE_HASH_TABLE_H_INCLUDED
+#define DURABLE_HASH_TABLE_H_INCLUDED
+
+#include "includes.h"
+#include "hash_table.h"
+#include "hash_function.h"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+// HashTable с журналом упреждающей записи (WAL). Каждый успешный
+// push/del дописывается в журнал, и вызов возвращается только после
+// fsync журнала. Групповая фиксация: записи, накопившиеся, пока идёт
+// один fsync, сбрасываются следующим одним write и одним fsync, так что
+// параллельные потоки делят fsync между собой.
+//
+// Файлы (base - путь, переданный в open):
+//   base.snap    - снимок в формате saveToBinaryFile;
+//   base.wal     - текущий журнал;
+//   base.wal.old - журнал, который сворачивается в новый снимок.
+// Восстановление: снимок, затем base.wal.old, затем base.wal. Запись
+// журнала с оборванным хвостом или неверной контрольной суммой
+// считается концом журнала. Повтор уже вошедших в снимок операций
+// безопасен: для каждого ключа в журнале чередуются успешные push и del,
+// и итоговое состояние ключа задаёт последняя операция.
+class DurableHashTable {
+private:
+    static constexpr char OP_PUSH = 'P';
+    static constexpr char OP_DEL = 'D';
+    // Заголовок записи: CRC32 остальной записи, операция, длины ключа и значения
+    static constexpr size_t RECORD_HEADER = 4 + 1 + 4 + 4;
+
+    HashTable* table; // существует, пока таблица открыта
+    size_t initialCapacity;
+    mutable shared_mutex tableLock; // порядок захвата: tableLock, затем commitLock
+
+    string base;
+    int logFd;
+
+    // Групповая фиксация: pending - записи, ещё не переданные в write;
+    // запись с номером seq надёжна, когда syncedSeq >= seq
+    mutex commitLock;
+    condition_variable committed;
+    string pending;
+    uint64_t appendedSeq;
+    uint64_t syncedSeq;
+    bool syncing;
+    bool failed; // ошибка записи журнала, дальнейшие изменения не принимаются
+    uint64_t syncCount;
+    size_t logBytes;
+
+    thread compactor;
+    bool compacting; // фоновая свёртка ещё не закончилась
+    size_t compactThreshold; // размер журнала, после которого запускается свёртка (0 - вручную)
+
+    static bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    static void syncDirectory(const string& path) {
+        size_t slash = path.find_last_of('/');
+        string dir = slash == string::npos ? "." : path.substr(0, max<size_t>(slash, 1));
+        int fd = ::open(dir.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    // CRC32 (IEEE 802.3, полином 0xEDB88320) по таблице на 256 значений:
+    // гарантированно ловит любую пачку ошибок длиной до 32 бит
+    static uint32_t checksum(const char* data, size_t size) {
+        static const auto table = [] {
+            array<uint32_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    static void appendRecord(string& out, char op, string_view key, string_view value) {
+        size_t start = out.size();
+        out.resize(start + RECORD_HEADER);
+        char* header = &out[start];
+        uint32_t keySize = static_cast<uint32_t>(key.size());
+        uint32_t valueSize = static_cast<uint32_t>(value.size());
+        header[4] = op;
+        memcpy(header + 5, &keySize, 4);
+        memcpy(header + 9, &valueSize, 4);
+        out.append(key.data(), key.size());
+        out.append(value.data(), value.size());
+        uint32_t sum = checksum(out.data() + start + 4, out.size() - start - 4);
+        memcpy(&out[start], &sum, 4);
+    }
+
+    // Повтор журнала; возвращает длину его целой части
+    size_t replay(const string& content) {
+        size_t pos = 0;
+        while (content.size() - pos >= RECORD_HEADER) {
+            uint32_t sum, keySize, valueSize;
+            memcpy(&sum, content.data() + pos, 4);
+            char op = content[pos + 4];
+            memcpy(&keySize, content.data() + pos + 5, 4);
+            memcpy(&valueSize, content.data() + pos + 9, 4);
+            size_t body = static_cast<size_t>(keySize) + valueSize;
+            if (content.size() - pos - RECORD_HEADER < body
+                || checksum(content.data() + pos + 4, RECORD_HEADER - 4 + body) != sum) {
+                break;
+            }
+            string_view key(content.data() + pos + RECORD_HEADER, keySize);
+            uint64_t hash = table->hashFunction(key);
+            if (op == OP_PUSH) {
+                if (table->find(key, hash) == nullptr) {
+                    table->insert(key, string_view(key.data() + keySize, valueSize), hash);
+                }
+            } else if (op == OP_DEL) {
+                table->remove(key, hash);
+            } else {
+                break;
+            }
+            pos += RECORD_HEADER + body;
+        }
+        return pos;
+    }
+
+    // Снимок пишется во временный файл и атомарно заменяет старый
+    static bool writeSnapshot(const string& path, const string& content) {
+        string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = writeAll(fd, content.data(), content.size()) && ::fsync(fd) == 0;
+        ::close(fd);
+        if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        syncDirectory(path);
+        return true;
+    }
+
+    // Запись пары в формате saveToBinaryFile
+    static void appendPair(string& content, string_view key, string_view value) {
+        size_t keySize = key.size();
+        size_t valueSize = value.size();
+        content.append(reinterpret_cast<const char*>(&keySize), sizeof(keySize));
+        content.append(key.data(), keySize);
+        content.append(reinterpret_cast<const char*>(&valueSize), sizeof(valueSize));
+        content.append(value.data(), valueSize);
+    }
+
+    string serialize() const {
+        string content;
+        table->forEachPair([&](const HashTable::KeyValuePair* current) {
+            appendPair(content, current->key(), current->value());
+        });
+        return content;
+    }
+
+    // Ожидание надёжности записи seq. Первый пришедший поток становится
+    // ведущим: забирает все накопленные записи и делает write + fsync,
+    // остальные ждут его результата; новые записи за это время копятся
+    // для следующего ведущего
+    bool waitDurable(uint64_t seq) {
+        unique_lock<mutex> guard(commitLock);
+        while (syncedSeq < seq && !failed) {
+            if (syncing) {
+                committed.wait(guard);
+                continue;
+            }
+            syncing = true;
+            string batch;
+            batch.swap(pending);
+            uint64_t target = appendedSeq;
+            int fd = logFd;
+            guard.unlock();
+            bool ok = writeAll(fd, batch.data(), batch.size()) && ::fdatasync(fd) == 0;
+            guard.lock();
+            syncing = false;
+            if (ok) {
+                syncedSeq = target;
+                logBytes += batch.size();
+                ++syncCount;
+            } else {
+                failed = true;
+                cerr << "Error writing log." << endl;
+            }
+            committed.notify_all();
+        }
+        return syncedSeq >= seq;
+    }
+
+    // Запись в журнал; вызывается под tableLock, чтобы порядок записей
+    // совпадал с порядком изменений таблицы
+    uint64_t logOperation(char op, string_view key, string_view value) {
+        lock_guard<mutex> guard(commitLock);
+        appendRecord(pending, op, key, value);
+        return ++appendedSeq;
+    }
+
+    void maybeCompact() {
+        if (compactThreshold == 0) {
+            return;
+        }
+        {
+            lock_guard<mutex> guard(commitLock);
+            if (logBytes < compactThreshold) {
+                return;
+            }
+        }
+        startCompaction();
+    }
+
+    // Свёртка: под блокировкой таблицы журнал сбрасывается и заменяется
+    // новым, и берётся снимок таблицы с копированием при записи;
+    // сериализация снимка, запись его на диск и удаление старого журнала
+    // идут уже без блокировки, параллельно с push/del.
+    // Если base.wal.old остался от неудачной свёртки, журнал не
+    // переименовывается поверх него: снимок покрывает и base.wal.old, и
+    // текущий журнал, поэтому после записи снимка base.wal.old удаляется,
+    // а записи текущего журнала при восстановлении просто повторятся.
+    // Вызывается только владельцем флага compacting
+    bool compactNow() {
+        unique_ptr<HashTable::Snapshot> snapshot;
+        {
+            unique_lock<shared_mutex> tableGuard(tableLock);
+            if (!waitDurable(appendedSeq)) {
+                return false;
+            }
+            // Снимок берётся до смены журнала: если он невозможен (другой
+            // снимок ещё жив), журнал остаётся прежним
+            snapshot = table->snapshot();
+            if (snapshot == nullptr) {
+                return false;
+            }
+            lock_guard<mutex> guard(commitLock);
+            string logPath = base + ".wal";
+            string oldPath = base + ".wal.old";
+            if (!fs::exists(oldPath)) {
+                if (::rename(logPath.c_str(), oldPath.c_str()) != 0) {
+                    return false;
+                }
+                int fd = ::open(logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+                if (fd < 0) {
+                    failed = true;
+                    cerr << "Error writing log." << endl;
+                    return false;
+                }
+                syncDirectory(logPath);
+                ::close(logFd);
+                logFd = fd;
+                logBytes = 0;
+            }
+        }
+        string content;
+        snapshot->forEachPair([&](string_view key, string_view value) {
+            appendPair(content, key, value);
+        });
+        snapshot.reset();
+        if (!writeSnapshot(base + ".snap", content)) {
+            cerr << "Error writing snapshot." << endl;
+            return false; // base.wal.old остаётся и будет повторён при восстановлении
+        }
+        ::unlink((base + ".wal.old").c_str());
+        return true;
+    }
+
+public:
+    DurableHashTable(size_t initialCapacity = 10)
+        : table(nullptr), initialCapacity(initialCapacity), logFd(-1), appendedSeq(0), syncedSeq(0),
+          syncing(false), failed(false), syncCount(0), logBytes(0), compacting(false), compactThreshold(0) {}
+
+    ~DurableHashTable() {
+        close();
+    }
+
+    DurableHashTable(const DurableHashTable&) = delete;
+    DurableHashTable& operator=(const DurableHashTable&) = delete;
+
+    // Восстановление из base.snap и журналов и открытие журнала на дозапись
+    bool open(const string& basePath) {
+        close();
+        base = basePath;
+        table = new HashTable(initialCapacity);
+        table->loadFromBinaryFile(base + ".snap", true);
+        replay(HashTable::readWholeFile(base + ".wal.old"));
+        string logPath = base + ".wal";
+        string log = HashTable::readWholeFile(logPath);
+        size_t valid = replay(log);
+        logFd = ::open(logPath.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (logFd < 0 || ::ftruncate(logFd, valid) != 0 || ::lseek(logFd, 0, SEEK_END) < 0) {
+            cerr << "Error opening log." << endl;
+            close();
+            return false;
+        }
+        logBytes = valid;
+        // Незавершённая свёртка: её журнал уже повторён, снимок пишется заново
+        if (fs::exists(base + ".wal.old")) {
+            if (!writeSnapshot(base + ".snap", serialize())) {
+                cerr << "Error writing snapshot." << endl;
+                close();
+                return false;
+            }
+            ::unlink((base + ".wal.old").c_str());
+        }
+        return true;
+    }
+
+    // Ждёт фоновую свёртку и закрывает журнал; таблица в памяти очищается
+    void close() {
+        waitForCompaction();
+        if (logFd >= 0) {
+            waitDurable(appendedSeq);
+            ::close(logFd);
+        }
+        logFd = -1;
+        delete table;
+        table = nullptr;
+        pending.clear();
+        appendedSeq = syncedSeq = 0;
+        failed = false;
+        logBytes = 0;
+    }
+
+    bool isOpen() const {
+        return logFd >= 0;
+    }
+
+    // Возвращает true, когда изменение записано в журнал и журнал
+    // сброшен на диск
+    bool push(string_view key, string_view value) {
+        uint64_t seq;
+        {
+            unique_lock<shared_mutex> guard(tableLock);
+            if (logFd < 0 || failed) {
+                return false;
+            }
+            uint64_t hash = table->hashFunction(key);
+            if (table->find(key, hash) != nullptr) {
+                cout << "6:ERROR: Key already exists." << endl;
+                return false;
+            }
+            table->insert(key, value, hash);
+            seq = logOperation(OP_PUSH, key, value);
+        }
+        bool durable = waitDurable(seq);
+        maybeCompact();
+        return durable;
+    }
+
+    bool del(string_view key) {
+        uint64_t seq;
+        {
+            unique_lock<shared_mutex> guard(tableLock);
+            if (logFd < 0 || failed || !table->del(key)) {
+                return false; // Ключ не найден
+            }
+            seq = logOperation(OP_DEL, key, string_view());
+        }
+        bool durable = waitDurable(seq);
+        maybeCompact();
+        return durable;
+    }
+
+    // Чтение видит изменения, которые ещё ждут своего fsync
+    bool get(string_view key, string& result) const {
+        shared_lock<shared_mutex> guard(tableLock);
+        return table != nullptr && table->get(key, result);
+    }
+
+    // Запуск свёртки журнала в снимок в фоновом потоке;
+    // false - другая свёртка (фоновая или compact()) ещё идёт
+    bool startCompaction() {
+        lock_guard<mutex> guard(commitLock);
+        if (compacting || logFd < 0) {
+            return false;
+        }
+        if (compactor.joinable()) {
+            compactor.join(); // поток предыдущей свёртки уже завершается
+        }
+        compacting = true;
+        compactor = thread([this]() {
+            compactNow();
+            lock_guard<mutex> done(commitLock);
+            compacting = false;
+        });
+        return true;
+    }
+
+    void waitForCompaction() {
+        thread finished;
+        {
+            lock_guard<mutex> guard(commitLock);
+            finished.swap(compactor);
+        }
+        if (finished.joinable()) {
+            finished.join();
+        }
+    }
+
+    // Свёртка в текущем потоке; флаг compacting захватывается под тем же
+    // замком, что и в startCompaction, поэтому свёртки не пересекаются
+    bool compact() {
+        while (true) {
+            waitForCompaction();
+            lock_guard<mutex> guard(commitLock);
+            if (logFd < 0) {
+                return false;
+            }
+            if (!compacting) {
+                compacting = true;
+                break;
+            }
+        }
+        bool ok = compactNow();
+        lock_guard<mutex> guard(commitLock);
+        compacting = false;
+        return ok;
+    }
+
+    // Автоматическая фоновая свёртка, когда журнал вырастает до bytes (0 - отключить)
+    void setCompactionThreshold(size_t bytes) {
+        compactThreshold = bytes;
+    }
+
+    size_t getSize() const {
+        shared_lock<shared_mutex> guard(tableLock);
+        return table != nullptr ? table->getSize() : 0;
+    }
+
+    // Размер текущего журнала на диске
+    size_t getLogSize() {
+        lock_guard<mutex> guard(commitLock);
+        return logBytes;
+    }
+
+    // Число выполненных fsync журнала: при групповой фиксации оно
+    // меньше числа изменений
+    uint64_t getSyncCount() {
+        lock_guard<mutex> guard(commitLock);
+        return syncCount;
+    }
+};
+
+#endif // DURABLE_HASH_TABLE_H_INCLUDED
@@ -0,0 +1,151 @@
+#ifndef EXPORTER_H_INCLUDED
+#define EXPORTER_H_INCLUDED
+
+#include "includes.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Текстовая выгрузка контейнеров: записи форматируются в большой буфер
+// в памяти и уходят в файл крупными блоками, без сброса потока на
+// каждой записи. Поле длиннее LARGE_FIELD без спецсимволов не копируется
+// в буфер, а дописывается вместе с ним одним writev.
+//
+// Экранирование полей: ';' -> "\;", '\' -> "\\", перевод строки -> "\n".
+// Так разделитель ';' и конец строки в файле всегда настоящие, а
+// LineScanner восстанавливает исходные строки.
+class TextExporter {
+private:
+    static constexpr size_t LARGE_FIELD = 64 * 1024;
+
+    int fd;
+    char* buffer;
+    size_t capacity;
+    size_t used;
+    bool failed;
+
+    static bool special(char c) {
+        return c == ';' || c == '\\' || c == '\n';
+    }
+
+    bool writeAll(const char* data, size_t size) {
+        while (size > 0 && !failed) {
+            ssize_t written = ::write(fd, data, size);
+            if (written <= 0) {
+                failed = true;
+                break;
+            }
+            data += written;
+            size -= written;
+        }
+        return !failed;
+    }
+
+    // Буфер и большое поле одним системным вызовом
+    void writeWithBuffer(string_view field) {
+        iovec parts[2] = {{buffer, used}, {const_cast<char*>(field.data()), field.size()}};
+        ssize_t written = ::writev(fd, parts, 2);
+        if (written < 0) {
+            failed = true;
+            return;
+        }
+        size_t done = static_cast<size_t>(written);
+        if (done < used) {
+            writeAll(buffer + done, used - done);
+            done = used;
+        }
+        writeAll(field.data() + (done - used), field.size() - (done - used));
+        used = 0;
+    }
+
+public:
+    TextExporter(const string& filename, size_t bufferSize = 1 << 20)
+        : capacity(max<size_t>(bufferSize, 64)), used(0), failed(false) {
+        fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        failed = fd < 0; // close() сообщит, что файл не создан
+        buffer = new char[capacity];
+    }
+
+    ~TextExporter() {
+        close();
+        delete[] buffer;
+    }
+
+    TextExporter(const TextExporter&) = delete;
+    TextExporter& operator=(const TextExporter&) = delete;
+
+    bool isOpen() const {
+        return fd >= 0;
+    }
+
+    void flush() {
+        if (fd >= 0 && used > 0) {
+            writeAll(buffer, used);
+        }
+        used = 0;
+    }
+
+    // Разделитель или другой текст без экранирования
+    void write(char c) {
+        if (used == capacity) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+    void write(string_view text) {
+        if (text.size() > capacity - used) {
+            flush();
+            if (text.size() >= capacity) {
+                if (fd >= 0) {
+                    writeAll(text.data(), text.size());
+                }
+                return;
+            }
+        }
+        memcpy(buffer + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    // Значение поля с экранированием; участки без спецсимволов
+    // копируются целиком
+    void writeField(string_view field) {
+        if (field.size() >= LARGE_FIELD && fd >= 0) {
+            bool plain = true;
+            for (char c : field) {
+                if (special(c)) {
+                    plain = false;
+                    break;
+                }
+            }
+            if (plain) {
+                writeWithBuffer(field);
+                return;
+            }
+        }
+        size_t start = 0;
+        for (size_t i = 0; i < field.size(); ++i) {
+            if (special(field[i])) {
+                write(field.substr(start, i - start));
+                write('\\');
+                write(field[i] == '\n' ? 'n' : field[i]);
+                start = i + 1;
+            }
+        }
+        write(field.substr(start));
+    }
+
+    // Запись буфера и закрытие файла; false - файл не открылся или при
+    // записи была ошибка
+    bool close() {
+        flush();
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        return !failed;
+    }
+};
+
+#endif // EXPORTER_H_INCLUDED
@@ -0,0 +1,295 @@
+#ifndef FLAT_HASH_TABLE_H_INCLUDED
+#define FLAT_HASH_TABLE_H_INCLUDED
+
+#include "includes.h"
+#include "hash_function.h"
+#include "exporter.h"
+#include "line_scanner.h"
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Хеш-таблица с открытой адресацией: пары лежат в плоском массиве слотов,
+// а для каждого слота хранится управляющий байт (7 бит хеша или метка
+// пустого/удалённого слота). Слоты сгруппированы по 16, и группа
+// проверяется одной SSE2-инструкцией сравнения.
+// Интерфейс и форматы файлов совпадают с HashTable.
+class FlatHashTable {
+private:
+    static const size_t GROUP = 16;
+    static const int8_t EMPTY = -128; // 0x80
+    static const int8_t DELETED = -2; // 0xFE
+
+    class Slot {
+    public:
+        string key;
+        string value;
+    };
+
+    int8_t* ctrl; // управляющие байты, по одному на слот
+    Slot* slots;
+    size_t capacity; // степень двойки, не меньше GROUP
+    size_t count;
+    size_t deleted; // количество надгробий
+
+    static size_t hashFunction(string_view key) {
+        return fastHash(key);
+    }
+
+    static int8_t h2(size_t hash) {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    // Битовая маска слотов группы, чей управляющий байт равен value
+    static uint32_t match(const int8_t* group, int8_t value) {
+#ifdef __SSE2__
+        __m128i ctrlBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrlBytes, _mm_set1_epi8(value))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP; ++i) {
+            if (group[i] == value) {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+#endif
+    }
+
+    // Маска свободных (пустых или удалённых) слотов: у обеих меток старший бит равен 1
+    static uint32_t matchFree(const int8_t* group) {
+#ifdef __SSE2__
+        __m128i ctrlBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(ctrlBytes));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP; ++i) {
+            if (group[i] < 0) {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+#endif
+    }
+
+    static int lowestBit(uint32_t mask) {
+        return __builtin_ctz(mask);
+    }
+
+    // Индекс слота с ключом или capacity, если ключа нет
+    size_t findIndex(string_view key, size_t hash) const {
+        size_t groupMask = capacity / GROUP - 1;
+        size_t group = (hash >> 7) & groupMask;
+        for (size_t probe = 1; ; ++probe) {
+            const int8_t* groupCtrl = ctrl + group * GROUP;
+            uint32_t mask = match(groupCtrl, h2(hash));
+            while (mask != 0) {
+                size_t index = group * GROUP + lowestBit(mask);
+                if (slots[index].key == key) {
+                    return index;
+                }
+                mask &= mask - 1;
+            }
+            if (match(groupCtrl, EMPTY) != 0 || probe > groupMask) {
+                return capacity;
+            }
+            group = (group + probe) & groupMask; // треугольное зондирование по группам
+        }
+    }
+
+    // Первый свободный слот на пути зондирования
+    size_t findFree(size_t hash) const {
+        size_t groupMask = capacity / GROUP - 1;
+        size_t group = (hash >> 7) & groupMask;
+        for (size_t probe = 1; ; ++probe) {
+            uint32_t mask = matchFree(ctrl + group * GROUP);
+            if (mask != 0) {
+                return group * GROUP + lowestBit(mask);
+            }
+            group = (group + probe) & groupMask;
+        }
+    }
+
+    void allocate(size_t newCapacity) {
+        capacity = newCapacity;
+        ctrl = new int8_t[capacity];
+        for (size_t i = 0; i < capacity; ++i) {
+            ctrl[i] = EMPTY;
+        }
+        slots = new Slot[capacity];
+        count = 0;
+        deleted = 0;
+    }
+
+    // Перенос всех пар в новый массив; заодно вычищаются надгробия
+    void rehash(size_t newCapacity) {
+        int8_t* oldCtrl = ctrl;
+        Slot* oldSlots = slots;
+        size_t oldCapacity = capacity;
+        allocate(newCapacity);
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (oldCtrl[i] >= 0) {
+                size_t hash = hashFunction(oldSlots[i].key);
+                size_t index = findFree(hash);
+                ctrl[index] = h2(hash);
+                slots[index].key = move(oldSlots[i].key);
+                slots[index].value = move(oldSlots[i].value);
+                ++count;
+            }
+        }
+        delete[] oldCtrl;
+        delete[] oldSlots;
+    }
+
+public:
+    FlatHashTable(size_t initialCapacity = 16) {
+        size_t newCapacity = GROUP;
+        while (newCapacity < initialCapacity) {
+            newCapacity *= 2;
+        }
+        allocate(newCapacity);
+    }
+
+    ~FlatHashTable() {
+        delete[] ctrl;
+        delete[] slots;
+    }
+
+    FlatHashTable(const FlatHashTable&) = delete;
+    FlatHashTable& operator=(const FlatHashTable&) = delete;
+
+    void push(string_view key, string_view value) {
+        size_t hash = hashFunction(key);
+        if (findIndex(key, hash) != capacity) {
+            cout << "6:ERROR: Key already exists." << endl;
+            return;
+        }
+        // Заполненность вместе с надгробиями держится не выше 7/8
+        if ((count + deleted + 1) * 8 > capacity * 7) {
+            rehash(count * 2 + 2 > capacity ? capacity * 2 : capacity);
+        }
+        size_t index = findFree(hash);
+        if (ctrl[index] == DELETED) {
+            --deleted;
+        }
+        ctrl[index] = h2(hash);
+        slots[index].key = key;
+        slots[index].value = value;
+        ++count;
+    }
+
+    bool get(string_view key, string& result) const {
+        size_t index = findIndex(key, hashFunction(key));
+        if (index == capacity) {
+            return false; // Ключ не найден
+        }
+        result = slots[index].value;
+        return true;
+    }
+
+    // Поиск без копирования; result действителен до следующего push или del
+    bool get(string_view key, string_view& result) const {
+        size_t index = findIndex(key, hashFunction(key));
+        if (index == capacity) {
+            return false; // Ключ не найден
+        }
+        result = slots[index].value;
+        return true;
+    }
+
+    bool del(string_view key) {
+        size_t index = findIndex(key, hashFunction(key));
+        if (index == capacity) {
+            return false; // Ключ не найден
+        }
+        // Если в группе уже есть пустой слот, поиск через неё не проходит,
+        // и надгробие не нужно
+        const int8_t* groupCtrl = ctrl + index / GROUP * GROUP;
+        if (match(groupCtrl, EMPTY) != 0) {
+            ctrl[index] = EMPTY;
+        } else {
+            ctrl[index] = DELETED;
+            ++deleted;
+        }
+        slots[index] = Slot();
+        --count;
+        return true;
+    }
+
+    // Сохранение в текстовый файл
+    void saveToFile(const string& filename) const {
+        TextExporter file(filename);
+        if (!file.isOpen()) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        for (size_t i = 0; i < capacity; ++i) {
+            if (ctrl[i] >= 0) {
+                file.writeField(slots[i].key);
+                file.write(';');
+                file.writeField(slots[i].value);
+                file.write('\n');
+            }
+        }
+        if (!file.close()) {
+            cerr << "Error writing file." << endl;
+        }
+    }
+
+    // Загрузка из текстового файла
+    void loadFromFile(const string& filename) {
+        ifstream file(filename, ios::binary);
+        string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        LineScanner scanner(content.data(), content.data() + content.size());
+        string_view key, value;
+        while (scanner.next(key, value)) {
+            push(key, value);
+        }
+    }
+
+    // Сохранение в бинарный файл
+    void saveToBinaryFile(const string& filename) const {
+        ofstream file(filename, ios::binary);
+        for (size_t i = 0; i < capacity; ++i) {
+            if (ctrl[i] >= 0) {
+                size_t keySize = slots[i].key.size();
+                size_t valueSize = slots[i].value.size();
+                file.write(reinterpret_cast<char*>(&keySize), sizeof(keySize));
+                file.write(slots[i].key.c_str(), keySize);
+                file.write(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
+                file.write(slots[i].value.c_str(), valueSize);
+            }
+        }
+        file.close();
+    }
+
+    // Загрузка из бинарного файла
+    void loadFromBinaryFile(const string& filename) {
+        ifstream file(filename, ios::binary);
+        while (file) {
+            size_t keySize, valueSize;
+            if (!file.read(reinterpret_cast<char*>(&keySize), sizeof(keySize))) break;
+
+            string key(keySize, '\0');
+            file.read(&key[0], keySize);
+
+            file.read(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
+            string value(valueSize, '\0');
+            file.read(&value[0], valueSize);
+
+            push(key, value);
+        }
+        file.close();
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    size_t getSize() const {
+        return count;
+    }
+};
+
+#endif // FLAT_HASH_TABLE_H_INCLUDED
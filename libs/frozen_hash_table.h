@@ -0,0 +1,284 @@
+#ifndef FROZEN_HASH_TABLE_H_INCLUDED
+#define FROZEN_HASH_TABLE_H_INCLUDED
+
+#include "includes.h"
+#include "hash_table.h"
+#include "hash_function.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Формат замороженной таблицы; в памяти и в файле он одинаков:
+//   FrozenHeader;
+//   pilots[bucketCount] - смещение (pilot) каждой группы ключей;
+//   FrozenEntry[count] - ровно одна запись на ключ, пустых мест нет;
+//   данные - ключ и сразу за ним значение для каждой записи.
+class FrozenHeader {
+public:
+    static constexpr char MAGIC[8] = {'H', 'T', 'F', 'R', 'O', 'Z', '0', '2'};
+
+    char magic[8];
+    uint64_t count;
+    uint64_t bucketCount;
+    uint64_t hashSeed;
+    uint64_t pilotsOffset;
+    uint64_t entriesOffset;
+    uint64_t dataOffset;
+    uint64_t fileSize;
+};
+
+class FrozenEntry {
+public:
+    uint64_t keyOffset; // смещение ключа от начала образа
+    uint32_t keySize;
+    uint32_t valueSize;
+};
+
+// Неизменяемая таблица на минимальной совершенной хеш-функции
+// (схема hash-and-displace): ключи разбиты на группы по старшим битам
+// хеша, и для каждой группы при построении подобран pilot, при котором
+// все её ключи попадают в ещё свободные позиции [0, count). Поиск -
+// хеш, чтение pilot своей группы и одна запись: ни цепочек, ни пустых
+// корзин, ни указателей next. Отсутствующий ключ тоже попадает в
+// какую-то позицию, поэтому ключ записи всегда сравнивается.
+class FrozenHashTable {
+private:
+    static constexpr uint64_t KEYS_PER_BUCKET = 4;
+    static constexpr int BUILD_ATTEMPTS = 8; // зёрна на случай совпавших 64-битных хешей
+
+    string image;
+    const FrozenHeader* header;
+    const uint32_t* pilots;
+    const FrozenEntry* entries;
+
+    static uint64_t rangeOf(uint64_t hash, uint64_t size) {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(hash) * size) >> 64);
+    }
+
+    static uint64_t position(uint64_t hash, uint32_t pilot, uint64_t count) {
+        return rangeOf(hashMix(hash ^ hashMix(pilot + 1, 0x9e3779b97f4a7c15ULL), 0xe7037ed1a0b428dbULL), count);
+    }
+
+    // Подбор pilot для всех групп; false - какую-то группу разместить
+    // не удалось (например, два ключа с одинаковым хешем)
+    static bool placeAll(const vector<uint64_t>& hashes, uint64_t bucketCount,
+                         vector<uint32_t>& pilotOf, vector<uint64_t>& slotOf) {
+        uint64_t n = hashes.size();
+        // Ключи, сгруппированные по группам (сортировка подсчётом)
+        vector<uint64_t> start(bucketCount + 1, 0);
+        for (uint64_t hash : hashes) {
+            ++start[rangeOf(hash, bucketCount) + 1];
+        }
+        uint64_t largest = 0;
+        for (uint64_t b = 0; b < bucketCount; ++b) {
+            largest = max(largest, start[b + 1]);
+            start[b + 1] += start[b];
+        }
+        vector<uint64_t> members(n);
+        vector<uint64_t> fill(start.begin(), start.end() - 1);
+        for (uint64_t i = 0; i < n; ++i) {
+            members[fill[rangeOf(hashes[i], bucketCount)]++] = i;
+        }
+        // Большие группы размещаются первыми, пока свободных мест много
+        vector<vector<uint64_t>> bySize(largest + 1);
+        for (uint64_t b = 0; b < bucketCount; ++b) {
+            bySize[start[b + 1] - start[b]].push_back(b);
+        }
+        vector<bool> taken(n, false);
+        vector<uint64_t> slots;
+        uint64_t maxTries = min<uint64_t>(64 * n + 1024, UINT32_MAX);
+        for (uint64_t size = largest; size > 0; --size) {
+            for (uint64_t b : bySize[size]) {
+                uint64_t tries = 0;
+                for (uint32_t pilot = 0;; ++pilot) {
+                    if (++tries > maxTries) {
+                        return false;
+                    }
+                    slots.clear();
+                    bool fits = true;
+                    for (uint64_t k = start[b]; k < start[b + 1] && fits; ++k) {
+                        uint64_t slot = position(hashes[members[k]], pilot, n);
+                        fits = !taken[slot] && std::find(slots.begin(), slots.end(), slot) == slots.end();
+                        slots.push_back(slot);
+                    }
+                    if (fits) {
+                        pilotOf[b] = pilot;
+                        for (uint64_t k = start[b]; k < start[b + 1]; ++k) {
+                            taken[slots[k - start[b]]] = true;
+                            slotOf[members[k]] = slots[k - start[b]];
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    const FrozenEntry* find(string_view key) const {
+        if (header == nullptr || header->count == 0) {
+            return nullptr;
+        }
+        uint64_t hash = fastHash(key, header->hashSeed);
+        uint32_t pilot = pilots[rangeOf(hash, header->bucketCount)];
+        const FrozenEntry& entry = entries[position(hash, pilot, header->count)];
+        if (entry.keySize == key.size()
+            && entry.keyOffset + entry.keySize + entry.valueSize <= image.size()
+            && memcmp(image.data() + entry.keyOffset, key.data(), key.size()) == 0) {
+            return &entry;
+        }
+        return nullptr;
+    }
+
+    bool validate() const {
+        if (image.size() < sizeof(FrozenHeader)) {
+            return false;
+        }
+        const FrozenHeader* h = reinterpret_cast<const FrozenHeader*>(image.data());
+        return memcmp(h->magic, FrozenHeader::MAGIC, sizeof(h->magic)) == 0 && h->fileSize == image.size()
+            && h->bucketCount > 0 && h->bucketCount <= image.size() / sizeof(uint32_t)
+            && h->count <= image.size() / sizeof(FrozenEntry)
+            && h->pilotsOffset >= sizeof(FrozenHeader) && h->pilotsOffset % alignof(uint32_t) == 0
+            && h->pilotsOffset <= image.size() && h->entriesOffset <= image.size()
+            && h->dataOffset <= image.size() // до сложений ниже: они не переполняются
+            && h->pilotsOffset + h->bucketCount * sizeof(uint32_t) <= h->entriesOffset
+            && h->entriesOffset % alignof(FrozenEntry) == 0
+            && h->entriesOffset + h->count * sizeof(FrozenEntry) <= h->dataOffset;
+    }
+
+    void attach() {
+        header = reinterpret_cast<const FrozenHeader*>(image.data());
+        pilots = reinterpret_cast<const uint32_t*>(image.data() + header->pilotsOffset);
+        entries = reinterpret_cast<const FrozenEntry*>(image.data() + header->entriesOffset);
+    }
+
+public:
+    FrozenHashTable() : header(nullptr), pilots(nullptr), entries(nullptr) {}
+
+    FrozenHashTable(const FrozenHashTable&) = delete;
+    FrozenHashTable& operator=(const FrozenHashTable&) = delete;
+
+    // Заморозка живого содержимого таблицы; сама таблица не меняется
+    bool build(const HashTable& table) {
+        vector<const HashTable::KeyValuePair*> pairs;
+        pairs.reserve(table.getSize());
+        uint64_t now = table.timeSource();
+        table.forEachPair([&](const HashTable::KeyValuePair* current) {
+            if (!HashTable::expired(current, now)) {
+                pairs.push_back(current); // просроченные записи не замораживаются
+            }
+        });
+        uint64_t n = pairs.size();
+        uint64_t bucketCount = n / KEYS_PER_BUCKET + 1;
+        vector<uint64_t> hashes(n);
+        vector<uint32_t> pilotOf(bucketCount, 0);
+        vector<uint64_t> slotOf(n);
+        uint64_t seed = DEFAULT_HASH_SEED;
+        bool placed = false;
+        for (int attempt = 0; attempt < BUILD_ATTEMPTS && !placed; ++attempt) {
+            seed = hashMix(seed + attempt, 0x9e3779b97f4a7c15ULL);
+            for (uint64_t i = 0; i < n; ++i) {
+                hashes[i] = fastHash(pairs[i]->key(), seed);
+            }
+            placed = placeAll(hashes, bucketCount, pilotOf, slotOf);
+        }
+        if (!placed) {
+            cerr << "Error: cannot build perfect hash." << endl;
+            return false;
+        }
+
+        FrozenHeader h = {};
+        memcpy(h.magic, FrozenHeader::MAGIC, sizeof(h.magic));
+        h.count = n;
+        h.bucketCount = bucketCount;
+        h.hashSeed = seed;
+        h.pilotsOffset = sizeof(FrozenHeader);
+        h.entriesOffset = (h.pilotsOffset + bucketCount * sizeof(uint32_t) + 7) / 8 * 8;
+        h.dataOffset = h.entriesOffset + n * sizeof(FrozenEntry);
+        uint64_t offset = h.dataOffset;
+        vector<FrozenEntry> slots(n);
+        for (uint64_t i = 0; i < n; ++i) {
+            FrozenEntry& entry = slots[slotOf[i]];
+            entry.keyOffset = offset;
+            entry.keySize = pairs[i]->keySize;
+            entry.valueSize = pairs[i]->valueSize;
+            offset += entry.keySize + entry.valueSize;
+        }
+        h.fileSize = offset;
+
+        image.assign(h.fileSize, '\0');
+        memcpy(&image[0], &h, sizeof(h));
+        memcpy(&image[h.pilotsOffset], pilotOf.data(), bucketCount * sizeof(uint32_t));
+        if (n > 0) {
+            memcpy(&image[h.entriesOffset], slots.data(), n * sizeof(FrozenEntry));
+        }
+        for (uint64_t i = 0; i < n; ++i) {
+            const FrozenEntry& entry = slots[slotOf[i]];
+            memcpy(&image[entry.keyOffset], pairs[i]->data(), entry.keySize + entry.valueSize);
+        }
+        attach();
+        return true;
+    }
+
+    // Образ сохраняется как есть, загрузка читает его одним блоком
+    bool saveToFile(const string& filename) const {
+        ofstream file(filename, ios::binary);
+        if (!file || header == nullptr) {
+            cerr << "Error opening file for serialization." << endl;
+            return false;
+        }
+        file.write(image.data(), image.size());
+        return static_cast<bool>(file);
+    }
+
+    bool loadFromFile(const string& filename) {
+        ifstream file(filename, ios::binary | ios::ate);
+        if (!file) {
+            cerr << "Error opening file for deserialization." << endl;
+            return false;
+        }
+        image.assign(static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        file.read(&image[0], image.size());
+        if (!file || !validate()) {
+            image.clear();
+            header = nullptr;
+            cerr << "Error: invalid frozen table format." << endl;
+            return false;
+        }
+        attach();
+        return true;
+    }
+
+    bool get(string_view key, string& result) const {
+        const FrozenEntry* entry = find(key);
+        if (entry == nullptr) {
+            return false; // Ключ не найден
+        }
+        result.assign(image.data() + entry->keyOffset + entry->keySize, entry->valueSize);
+        return true;
+    }
+
+    // Значение указывает внутрь образа и действительно до следующей
+    // build/loadFromFile
+    bool get(string_view key, string_view& result) const {
+        const FrozenEntry* entry = find(key);
+        if (entry == nullptr) {
+            return false; // Ключ не найден
+        }
+        result = string_view(image.data() + entry->keyOffset + entry->keySize, entry->valueSize);
+        return true;
+    }
+
+    size_t getSize() const {
+        return header != nullptr ? header->count : 0;
+    }
+
+    // Размер образа: заголовок, pilot, записи и данные
+    size_t getMemoryUsage() const {
+        return image.size();
+    }
+};
+
+#endif // FROZEN_HASH_TABLE_H_INCLUDED
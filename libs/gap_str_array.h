@@ -0,0 +1,198 @@
+#ifndef GAP_STR_ARRAY_H_INCLUDED
+#define GAP_STR_ARRAY_H_INCLUDED
+
+#include "includes.h"
+#include "exporter.h"
+
+// Массив строк на буфере с разрывом (gap buffer) с тем же интерфейсом,
+// что у StrArray. Свободные слоты собраны в один разрыв
+// [gapStart, gapEnd) внутри буфера: элементы с индексом < gapStart лежат
+// до него, остальные - после. Вставка и удаление работают на границе
+// разрыва за O(1), а сам разрыв переносится к месту правки перемещением
+// строк на расстояние от прошлой правки. Серия правок рядом друг с
+// другом обходится без сдвига хвоста массива; get и replace - O(1).
+class GapStrArray {
+private:
+    string* data;
+    size_t capacity;
+    size_t gapStart;
+    size_t gapEnd;
+
+    size_t physical(size_t index) const {
+        return index < gapStart ? index : index + (gapEnd - gapStart);
+    }
+
+    // Перенос разрыва так, чтобы он начинался с логического индекса index
+    void moveGap(size_t index) {
+        if (gapStart == gapEnd) {
+            gapStart = gapEnd = index; // пустой разрыв переносится даром
+            return;
+        }
+        while (gapStart > index) {
+            data[--gapEnd] = move(data[--gapStart]);
+        }
+        while (gapStart < index) {
+            data[gapStart++] = move(data[gapEnd++]);
+        }
+    }
+
+    // Рост вдвое; разрыв остаётся на месте и расширяется
+    void grow() {
+        size_t newCapacity = capacity > 0 ? capacity * 2 : 1;
+        string* newData = new string[newCapacity];
+        size_t tail = capacity - gapEnd;
+        for (size_t i = 0; i < gapStart; ++i) {
+            newData[i] = move(data[i]);
+        }
+        for (size_t i = 0; i < tail; ++i) {
+            newData[newCapacity - tail + i] = move(data[gapEnd + i]);
+        }
+        delete[] data;
+        data = newData;
+        gapEnd = newCapacity - tail;
+        capacity = newCapacity;
+    }
+
+public:
+    GapStrArray(size_t initialCapacity = 5)
+        : data(new string[initialCapacity]), capacity(initialCapacity), gapStart(0), gapEnd(initialCapacity) {}
+
+    ~GapStrArray() {
+        delete[] data;
+    }
+
+    GapStrArray(const GapStrArray&) = delete;
+    GapStrArray& operator=(const GapStrArray&) = delete;
+
+    GapStrArray(GapStrArray&& other) noexcept
+        : data(other.data), capacity(other.capacity), gapStart(other.gapStart), gapEnd(other.gapEnd) {
+        other.data = nullptr;
+        other.capacity = other.gapStart = other.gapEnd = 0;
+    }
+
+    GapStrArray& operator=(GapStrArray&& other) noexcept {
+        swap(data, other.data);
+        swap(capacity, other.capacity);
+        swap(gapStart, other.gapStart);
+        swap(gapEnd, other.gapEnd);
+        return *this;
+    }
+
+    void push(string value) {
+        pushi(sizeM(), move(value));
+    }
+
+    size_t sizeM() const {
+        return capacity - (gapEnd - gapStart);
+    }
+
+    void pushi(size_t index, string value) {
+        if (index > sizeM()) {
+            cout << "6:ERROR: Index out of range." << endl;
+            return;
+        }
+        if (gapStart == gapEnd) {
+            grow();
+        }
+        moveGap(index);
+        data[gapStart++] = move(value);
+    }
+
+    bool get(size_t index, string& result) const {
+        if (index >= sizeM()) {
+            return false;
+        }
+        result = data[physical(index)];
+        return true;
+    }
+
+    void replace(size_t index, string value) {
+        if (index >= sizeM()) {
+            cout << "9:ERROR: Index out of range." << endl;
+            return;
+        }
+        data[physical(index)] = move(value);
+    }
+
+    void del(size_t index) {
+        if (index >= sizeM()) {
+            cout << "11:ERROR: Index out of range." << endl;
+            return;
+        }
+        moveGap(index);
+        data[gapEnd++] = string(); // элемент поглощается разрывом
+    }
+
+    // Позиция разрыва: индекс, с которого начнётся следующая дешёвая правка
+    size_t getGapPosition() const {
+        return gapStart;
+    }
+
+    // Тот же формат, что у StrArray::saveToFile
+    void saveToFile(const string& filename) const {
+        TextExporter file(filename);
+        if (!file.isOpen()) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        size_t size = sizeM();
+        for (size_t i = 0; i < size; ++i) {
+            file.writeField(data[physical(i)]);
+            if (i + 1 < size) {
+                file.write(';');
+            }
+        }
+        if (!file.close()) {
+            cerr << "Error writing file." << endl;
+        }
+    }
+
+    // Тот же формат, что у StrArray::serialize
+    void serialize(const string& filename) const {
+        ofstream file(filename, ios::binary);
+        if (!file) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        size_t size = sizeM();
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(&capacity), sizeof(capacity));
+        for (size_t i = 0; i < size; ++i) {
+            const string& value = data[physical(i)];
+            size_t len = value.size();
+            file.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            file.write(value.data(), len);
+        }
+        file.close();
+    }
+
+    void deserialize(const string& filename) {
+        ifstream file(filename, ios::binary);
+        if (!file) {
+            cerr << "Error opening file for deserialization." << endl;
+            return;
+        }
+        size_t size = 0;
+        size_t newCapacity = 0;
+        file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        file.read(reinterpret_cast<char*>(&newCapacity), sizeof(newCapacity));
+        delete[] data;
+        capacity = max(size, newCapacity);
+        data = new string[capacity];
+        for (size_t i = 0; i < size; ++i) {
+            size_t len;
+            file.read(reinterpret_cast<char*>(&len), sizeof(len));
+            data[i].resize(len);
+            file.read(&data[i][0], len);
+        }
+        gapStart = size; // разрыв в конце
+        gapEnd = capacity;
+        file.close();
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+};
+
+#endif // GAP_STR_ARRAY_H_INCLUDED
@@ -0,0 +1,72 @@
+#ifndef HASH_FUNCTION_H_INCLUDED
+#define HASH_FUNCTION_H_INCLUDED
+
+#include "includes.h"
+#include <cstdint>
+#include <cstring>
+
+// Хеш-функция таблицы: ключ и зерно (seed)
+using HashFunction = uint64_t (*)(string_view key, uint64_t seed);
+
+const uint64_t DEFAULT_HASH_SEED = 0x243f6a8885a308d3ULL;
+
+// Перемножение 64x64 -> 128 бит со сложением половин через xor
+inline uint64_t hashMix(uint64_t a, uint64_t b) {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+inline uint64_t hashRead64(const char* p) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    return word;
+}
+
+inline uint64_t hashRead32(const char* p) {
+    uint32_t word;
+    memcpy(&word, p, 4);
+    return word;
+}
+
+// Хеш по умолчанию (по схеме wyhash): ключ читается 8-байтовыми словами,
+// пары слов проходят через 128-битное умножение. Короткие ключи до 16 байт
+// читаются двумя перекрывающимися словами без цикла по байтам.
+// Все 64 бита результата зависят от каждого байта, поэтому годятся
+// и старшие биты (номер корзины), и младшие (метки FlatHashTable).
+// Зерно сначала перемешивается: у ключей короче 4 байт второе слово
+// равно нулю, и нулевое зерно без перемешивания обнулило бы произведение.
+// При одинаковом зерне значение стабильно между запусками и может
+// сохраняться на диск.
+inline uint64_t fastHash(string_view key, uint64_t seed = DEFAULT_HASH_SEED) {
+    const uint64_t K0 = 0xa0761d6478bd642fULL;
+    const uint64_t K1 = 0xe7037ed1a0b428dbULL;
+    const char* p = key.data();
+    size_t n = key.size();
+    uint64_t a = 0;
+    uint64_t b = 0;
+    seed ^= hashMix(seed ^ K0, K1);
+    if (n <= 16) {
+        if (n >= 4) {
+            size_t shift = (n >> 3) << 2;
+            a = (hashRead32(p) << 32) | hashRead32(p + shift);
+            b = (hashRead32(p + n - 4) << 32) | hashRead32(p + n - 4 - shift);
+        } else if (n > 0) {
+            a = (static_cast<uint64_t>(static_cast<unsigned char>(p[0])) << 16)
+                | (static_cast<uint64_t>(static_cast<unsigned char>(p[n >> 1])) << 8)
+                | static_cast<unsigned char>(p[n - 1]);
+        }
+    } else {
+        size_t rest = n;
+        while (rest > 16) {
+            seed = hashMix(hashRead64(p) ^ K1, hashRead64(p + 8) ^ seed);
+            p += 16;
+            rest -= 16;
+        }
+        a = hashRead64(p + rest - 16);
+        b = hashRead64(p + rest - 8);
+    }
+    unsigned __int128 product = static_cast<unsigned __int128>(a ^ K1) * (b ^ seed);
+    return hashMix(static_cast<uint64_t>(product) ^ K0 ^ n, static_cast<uint64_t>(product >> 64) ^ K1);
+}
+
+#endif // HASH_FUNCTION_H_INCLUDED
@@ -2,165 +2,1496 @@
 #define HASH_TABLE_H_INCLUDED
 
 #include "includes.h"
+#include "slab_pool.h"
+#include "hash_function.h"
+#include "bloom_filter.h"
+#include "mapped_hash_table.h"
+#include "line_scanner.h"
+#include "exporter.h"
+#include "timer_wheel.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class HashTable {
+    friend class ConcurrentHashTable;
+    friend class LRUCache;
+    friend class DurableHashTable;
+    friend class FrozenHashTable;
+
 private:
+    static constexpr size_t INLINE_SIZE = 24;
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr size_t MULTI_GET_DISTANCE = 8;
+    static constexpr size_t PARALLEL_LOAD_MIN = 1 << 20; // меньшие файлы грузятся одним потоком
+    static constexpr size_t LOAD_BLOCKS = 256; // узлы, которые поток загрузки берёт из пула за раз
+
+    // Узел размером в кэш-линию берётся из пула, выровненного по линиям,
+    // и не пересекает их границу. Ключ и значение
+    // лежат подряд: внутри узла, если помещаются в INLINE_SIZE байт,
+    // иначе в одном общем буфере external. Полный хеш ключа хранится
+    // в узле: рост таблицы не пересчитывает хеши, а обход цепочки
+    // сравнивает строки только при совпадении хешей
     class KeyValuePair {
     public:
-        string key;
-        string value;
         KeyValuePair* next;
+        uint64_t hash;
+        uint32_t keySize;
+        uint32_t valueSize;
+        char* external;
+        uint64_t expireAt; // срок жизни в мс источника времени, 0 - бессрочно
+        char inlineData[INLINE_SIZE];
+
+        const char* data() const {
+            return external != nullptr ? external : inlineData;
+        }
+
+        string_view key() const {
+            return string_view(data(), keySize);
+        }
 
-        KeyValuePair(const string& k, const string& v) : key(k), value(v), next(nullptr) {}
+        string_view value() const {
+            return string_view(data() + keySize, valueSize);
+        }
     };
+    static_assert(sizeof(KeyValuePair) == CACHE_LINE, "node must fill one cache line");
+
+    SlabPool pool;
+    size_t externalCount; // узлы с внешним буфером, их нужно освобождать по одному
+
+    HashFunction hasher;
+    uint64_t seed;
 
     KeyValuePair** table;
     size_t tableSize;
+    size_t count; // количество элементов
+    size_t minCapacity; // ниже этой ёмкости таблица не сжимается
+    double maxLoadFactor; // порог роста
+    double minLoadFactor; // порог сжатия (0 - не сжимать)
+
+    // Постепенный рехеш: пока oldTable != nullptr, часть цепочек ещё лежит
+    // в старом массиве, корзины [0, rehashIndex) которого уже перенесены
+    KeyValuePair** oldTable;
+    size_t oldSize;
+    size_t rehashIndex;
+    bool incremental;
+    size_t rehashStep; // сколько корзин переносится за одну операцию
+
+    // Необязательный фильтр Блума перед цепочками: отсутствующий ключ
+    // отсекается чтением одной кэш-линии. Удаление не снимает биты,
+    // поэтому после bloomStale удалений фильтр перестраивается
+    BloomFilter* bloom;
+    size_t bloomStale;
+
+    // Состояние снимка с копированием при записи. Пока снимок жив,
+    // массив корзин не перестраивается, а перед первым изменением
+    // корзины её цепочка копируется в снимок. Снимок читает корзину
+    // под её маленькой блокировкой: скопированную - из копии, иначе -
+    // живую цепочку, которая с момента снимка не менялась. Время снимка
+    // фиксируется: записи, просроченные к нему, снимок не видит
+    class CowState {
+    public:
+        static constexpr uint8_t LOCKED = 1;
+        static constexpr uint8_t COPIED = 2;
+
+        KeyValuePair** table; // массив корзин на момент снимка
+        size_t tableSize;
+        size_t count; // живые записи на момент now
+        uint64_t now;
+        HashFunction hasher;
+        uint64_t seed;
+        unique_ptr<atomic<uint8_t>[]> states;
+        unique_ptr<KeyValuePair*[]> copies;
+        SlabPool pool; // узлы копий; выделяет только пишущий поток
+        atomic<bool> released; // снимок освобождён, таблица может отцепиться
+
+        CowState(KeyValuePair** liveTable, size_t size, size_t pairs, uint64_t time, HashFunction hashFunction,
+                 uint64_t hashSeed)
+            : table(liveTable), tableSize(size), count(pairs), now(time), hasher(hashFunction), seed(hashSeed),
+              states(new atomic<uint8_t>[size]), copies(new KeyValuePair*[size]()),
+              pool(sizeof(KeyValuePair)), released(false) {
+            for (size_t i = 0; i < size; ++i) {
+                states[i].store(0, memory_order_relaxed);
+            }
+        }
+
+        ~CowState() {
+            for (size_t i = 0; i < tableSize; ++i) {
+                for (KeyValuePair* current = copies[i]; current != nullptr; current = current->next) {
+                    delete[] current->external;
+                }
+            }
+        }
+
+        void lock(size_t index) {
+            uint8_t expected = states[index].load(memory_order_relaxed) & ~LOCKED;
+            while (!states[index].compare_exchange_weak(expected, expected | LOCKED, memory_order_acquire)) {
+                expected &= ~LOCKED;
+            }
+        }
 
-    size_t hashFunction(const string& key) const {
-        size_t hash = 0;
-        for (char c : key) {
-            hash = hash * 31 + c;
+        void unlock(size_t index) {
+            states[index].fetch_and(static_cast<uint8_t>(~LOCKED), memory_order_release);
         }
-        return hash % tableSize;
+
+        // Копия цепочки корзины до её первого изменения
+        void preserve(size_t index) {
+            if (states[index].load(memory_order_acquire) & COPIED) {
+                return;
+            }
+            lock(index);
+            if (!(states[index].load(memory_order_relaxed) & COPIED)) {
+                KeyValuePair** tail = &copies[index];
+                for (KeyValuePair* current = table[index]; current != nullptr; current = current->next) {
+                    *tail = initPair(pool.allocate(), current->key(), current->value(), current->hash);
+                    (*tail)->expireAt = current->expireAt;
+                    tail = &(*tail)->next;
+                }
+                states[index].fetch_or(COPIED, memory_order_relaxed);
+            }
+            unlock(index);
+        }
+
+        // Обход живых записей цепочки корзины в том виде, какой она была
+        // в момент снимка
+        template <typename Func>
+        void visit(size_t index, Func func) {
+            lock(index);
+            bool copied = states[index].load(memory_order_relaxed) & COPIED;
+            for (KeyValuePair* current = copied ? copies[index] : table[index]; current != nullptr;
+                 current = current->next) {
+                if (!expired(current, now)) {
+                    func(current);
+                }
+            }
+            unlock(index);
+        }
+    };
+
+    shared_ptr<CowState> cow;
+
+    // Сроки жизни: колесо хранит (хеш, срок) и создаётся при первой
+    // вставке с TTL. Сработавший таймер удаляет узел, только если срок
+    // в узле совпадает, поэтому удалённые и перезаписанные ключи
+    // отменять в колесе не нужно
+    TimerWheel* wheel;
+    TimeSource timeSource;
+
+    // Живые Iterator держат указатели на узлы своего участка, поэтому
+    // узлы, удалённые при обходе (в том числе колесом таймеров внутри
+    // push), не освобождаются, а копятся в retired до конца обхода
+    mutable size_t iterators;
+    KeyValuePair* retired;
+
+    uint64_t hashFunction(string_view key) const {
+        return hasher(key, seed);
     }
 
-public:
-    HashTable(size_t initialCapacity = 10) : tableSize(initialCapacity) {
-        table = new KeyValuePair*[tableSize];
-        for (size_t i = 0; i < tableSize; ++i) {
-            table[i] = nullptr;
+    // Номер корзины по старшим битам хеша (hash * size / 2^64):
+    // без деления и для любого размера таблицы
+    static size_t bucketIndex(uint64_t hash, size_t size) {
+        return static_cast<size_t>((static_cast<unsigned __int128>(hash) * size) >> 64);
+    }
+
+    KeyValuePair* createPair(string_view key, string_view value, uint64_t hash) {
+        KeyValuePair* pair = initPair(pool.allocate(), key, value, hash);
+        if (pair->external != nullptr) {
+            ++externalCount;
         }
+        return pair;
     }
 
-    ~HashTable() {
-        for (size_t i = 0; i < tableSize; ++i) {
-            KeyValuePair* current = table[i];
-            while (current != nullptr) {
-                KeyValuePair* next = current->next;
-                delete current;
-                current = next;
+    // Заполнение уже выделенного блока; externalCount не меняется,
+    // поэтому вызов безопасен из нескольких потоков
+    static KeyValuePair* initPair(void* block, string_view key, string_view value, uint64_t hash) {
+        KeyValuePair* pair = static_cast<KeyValuePair*>(block);
+        pair->next = nullptr;
+        pair->hash = hash;
+        pair->keySize = static_cast<uint32_t>(key.size());
+        pair->valueSize = static_cast<uint32_t>(value.size());
+        char* buffer = pair->inlineData;
+        pair->external = nullptr;
+        pair->expireAt = 0;
+        if (key.size() + value.size() > INLINE_SIZE) {
+            buffer = pair->external = new char[key.size() + value.size()];
+        }
+        if (!key.empty()) {
+            memcpy(buffer, key.data(), key.size());
+        }
+        if (!value.empty()) {
+            memcpy(buffer + key.size(), value.data(), value.size());
+        }
+        return pair;
+    }
+
+    // Перестройка фильтра по сохранённым хешам узлов
+    void fillBloomFilter(size_t expectedKeys) {
+        delete bloom;
+        bloom = new BloomFilter(expectedKeys);
+        forEachPair([&](const KeyValuePair* current) {
+            bloom->add(current->hash);
+        });
+        bloomStale = 0;
+    }
+
+    void bloomAdd(uint64_t hash) {
+        if (bloom == nullptr) {
+            return;
+        }
+        if (count > bloom->getExpectedKeys()) {
+            fillBloomFilter(count * 2); // вставленный узел уже в цепочке и попадёт в фильтр
+        } else {
+            bloom->add(hash);
+        }
+    }
+
+    void bloomRemoved() {
+        if (bloom != nullptr && ++bloomStale > bloom->getExpectedKeys() / 2) {
+            fillBloomFilter(bloom->getExpectedKeys());
+        }
+    }
+
+    void destroyPair(KeyValuePair* pair) {
+        if (iterators > 0) {
+            pair->next = retired; // узел может лежать в участке итератора
+            retired = pair;
+            return;
+        }
+        if (pair->external != nullptr) {
+            delete[] pair->external;
+            --externalCount;
+        }
+        pool.release(pair);
+    }
+
+    // Освобождение узлов, отложенных на время обхода
+    void releaseRetired() {
+        while (retired != nullptr) {
+            KeyValuePair* pair = retired;
+            retired = pair->next;
+            destroyPair(pair);
+        }
+    }
+
+    // Дополнительные байты сразу за каждым узлом (например, ссылки
+    // списка LRUCache). Задаются до первой вставки; узел с ними длиннее
+    // линии, и пул выравнивает его обычным образом, без добивки до 128 байт
+    bool setNodeExtra(size_t extra) {
+        return pool.setBlockSize(sizeof(KeyValuePair) + extra, extra > 0 ? alignof(max_align_t) : CACHE_LINE);
+    }
+
+    static void* nodeExtra(KeyValuePair* pair) {
+        return pair + 1;
+    }
+
+    // Есть ли живой снимок; освобождённый снимок отцепляется здесь,
+    // в пишущем потоке
+    bool snapshotActive() {
+        if (cow != nullptr && cow->released.load(memory_order_acquire)) {
+            cow.reset();
+        }
+        return cow != nullptr;
+    }
+
+    // Вызывается перед каждым изменением цепочки корзины index
+    void preserveBucket(size_t index) {
+        if (cow != nullptr && snapshotActive()) {
+            cow->preserve(index);
+        }
+    }
+
+    // Снимок перестаёт зависеть от живых цепочек: все корзины копируются
+    void detachSnapshot() {
+        if (cow != nullptr && snapshotActive()) {
+            for (size_t i = 0; i < cow->tableSize; ++i) {
+                cow->preserve(i);
             }
+            cow.reset();
         }
-        delete[] table;
     }
 
-    void push(const string& key, const string& value) {
-        size_t hash = hashFunction(key);
-        KeyValuePair* current = table[hash];
+    // Вставка нового ключа без проверки дубликатов; возвращает узел
+    KeyValuePair* insert(string_view key, string_view value, uint64_t hash) {
+        size_t index = bucketIndex(hash, tableSize);
+        preserveBucket(index);
+        KeyValuePair* newPair = createPair(key, value, hash);
+        newPair->next = table[index];
+        table[index] = newPair;
+        ++count;
+        bloomAdd(hash);
+        growIfNeeded();
+        return newPair;
+    }
+
+    // Вставка одной записи пакета или загрузки; unique - без проверки
+    // дубликатов. Рост по ходу вставки нужен, когда reserve не смог
+    // расширить таблицу заранее: пока жил снимок или размер пакета неизвестен
+    void bulkInsert(string_view key, string_view value, bool unique) {
+        uint64_t hash = hashFunction(key);
+        if (!unique && occupied(key, hash)) {
+            cout << "6:ERROR: Key already exists." << endl;
+            return;
+        }
+        insert(key, value, hash);
+    }
+
+    // Удаление по ключу и уже посчитанному хешу
+    bool remove(string_view key, uint64_t hash) {
+        if (oldTable != nullptr) {
+            migrate(rehashStep);
+        }
+        size_t index = bucketIndex(hash, tableSize);
+        if (cow != nullptr && findNode(key, hash) != nullptr) {
+            preserveBucket(index); // Во время снимка старого массива нет
+        }
+        bool removed = unlink(table[index], key, hash);
+        if (!removed && oldTable != nullptr) {
+            size_t oldIndex = bucketIndex(hash, oldSize);
+            removed = oldIndex >= rehashIndex && unlink(oldTable[oldIndex], key, hash);
+        }
+        if (!removed) {
+            return false; // Ключ не найден
+        }
+        --count;
+        bloomRemoved();
+        shrinkIfNeeded();
+        return true;
+    }
+
+    static KeyValuePair** allocTable(size_t size) {
+        KeyValuePair** newTable = new KeyValuePair*[size];
+        for (size_t i = 0; i < size; ++i) {
+            newTable[i] = nullptr;
+        }
+        return newTable;
+    }
+
+    // Перенос одной цепочки старого массива в текущий
+    void moveChain(KeyValuePair* current) {
         while (current != nullptr) {
-            if (current->key == key) {
-                cout << "6:ERROR: Key already exists." << endl;
-                return;
+            KeyValuePair* next = current->next;
+            size_t index = bucketIndex(current->hash, tableSize);
+            current->next = table[index];
+            table[index] = current;
+            current = next;
+        }
+    }
+
+    // Перенос не более steps корзин; пустые корзины тоже ограничены,
+    // чтобы одна операция не сканировала длинный пустой участок
+    void migrate(size_t steps) {
+        size_t emptyVisits = steps * 10;
+        while (steps > 0 && rehashIndex < oldSize) {
+            KeyValuePair* chain = oldTable[rehashIndex];
+            oldTable[rehashIndex++] = nullptr;
+            if (chain != nullptr) {
+                moveChain(chain);
+                --steps;
+            } else if (--emptyVisits == 0) {
+                break;
             }
-            current = current->next;
         }
-        KeyValuePair* newPair = new KeyValuePair(key, value);
-        newPair->next = table[hash];
-        table[hash] = newPair;
+        if (rehashIndex >= oldSize) {
+            delete[] oldTable;
+            oldTable = nullptr;
+            oldSize = 0;
+            rehashIndex = 0;
+        }
+    }
+
+    void finishRehash() {
+        while (oldTable != nullptr) {
+            migrate(oldSize);
+        }
+    }
+
+    // Перераспределение цепочек по новому массиву корзин; пока жив
+    // снимок, массив не меняется и рехеш откладывается
+    void rehash(size_t newSize) {
+        if (snapshotActive()) {
+            return;
+        }
+        finishRehash();
+        oldTable = table;
+        oldSize = tableSize;
+        rehashIndex = 0;
+        table = allocTable(newSize);
+        tableSize = newSize;
+        if (!incremental) {
+            finishRehash();
+        }
+    }
+
+    // Рост вдвое; если рост откладывался (например, пока жил снимок),
+    // таблица сразу растёт настолько, чтобы догнать количество элементов
+    void growIfNeeded() {
+        if (oldTable == nullptr && count > tableSize * maxLoadFactor) {
+            size_t newSize = tableSize * 2;
+            while (count > newSize * maxLoadFactor) {
+                newSize *= 2;
+            }
+            rehash(newSize);
+        }
+    }
+
+    void shrinkIfNeeded() {
+        if (oldTable == nullptr && minLoadFactor > 0 && tableSize > minCapacity
+            && count < tableSize * minLoadFactor) {
+            rehash(max(tableSize / 2, minCapacity));
+        }
+    }
+
+    // Срок записи наступил; часы читаются только для записей с TTL,
+    // поэтому поиск в таблице без TTL к ним не обращается
+    bool expired(const KeyValuePair* pair) const {
+        return pair->expireAt != 0 && pair->expireAt <= timeSource();
+    }
+
+    static bool expired(const KeyValuePair* pair, uint64_t now) {
+        return pair->expireAt != 0 && pair->expireAt <= now;
+    }
+
+    // Поиск живого узла: просроченный, но ещё не удалённый ключ отсутствует
+    KeyValuePair* find(string_view key, uint64_t hash) const {
+        KeyValuePair* pair = findNode(key, hash);
+        return pair != nullptr && expired(pair) ? nullptr : pair;
     }
 
-    bool get(const string& key, string& result) const {
-        size_t hash = hashFunction(key);
-        KeyValuePair* current = table[hash];
+    // true - ключ занят живой записью; просроченная запись удаляется
+    bool occupied(string_view key, uint64_t hash) {
+        KeyValuePair* pair = findNode(key, hash);
+        if (pair != nullptr && expired(pair)) {
+            remove(key, hash);
+            return false;
+        }
+        return pair != nullptr;
+    }
+
+    // Удаление всех записей, срок которых наступил; O(1) на таймер
+    size_t expireDue() {
+        if (wheel == nullptr) {
+            return 0;
+        }
+        uint64_t now = timeSource();
+        size_t removed = 0;
+        wheel->advance(now, [&](const TimerWheel::Timer& timer) {
+            KeyValuePair* current = table[bucketIndex(timer.id, tableSize)];
+            while (current != nullptr && !(current->hash == timer.id && current->expireAt == timer.expireAt)) {
+                current = current->next;
+            }
+            if (current == nullptr && oldTable != nullptr) {
+                size_t index = bucketIndex(timer.id, oldSize);
+                current = index >= rehashIndex ? oldTable[index] : nullptr;
+                while (current != nullptr && !(current->hash == timer.id && current->expireAt == timer.expireAt)) {
+                    current = current->next;
+                }
+            }
+            if (current != nullptr) {
+                removed += remove(current->key(), timer.id);
+            }
+        });
+        return removed;
+    }
+
+    // Вставка с уже посчитанным сроком (0 - бессрочно)
+    void pushExpiring(string_view key, string_view value, uint64_t expireAt) {
+        if (oldTable != nullptr) {
+            migrate(rehashStep);
+        }
+        expireDue();
+        uint64_t hash = hashFunction(key);
+        if (occupied(key, hash)) {
+            cout << "6:ERROR: Key already exists." << endl;
+            return;
+        }
+        KeyValuePair* pair = insert(key, value, hash);
+        if (expireAt != 0) {
+            if (wheel == nullptr) {
+                wheel = new TimerWheel(timeSource());
+            }
+            pair->expireAt = expireAt;
+            wheel->schedule(hash, expireAt);
+        }
+    }
+
+    // Поиск узла без учёта срока жизни
+    KeyValuePair* findNode(string_view key, uint64_t hash) const {
+        if (bloom != nullptr && !bloom->mayContain(hash)) {
+            return nullptr;
+        }
+        KeyValuePair* current = table[bucketIndex(hash, tableSize)];
         while (current != nullptr) {
-            if (current->key == key) {
-                result = current->value;
-                return true;
+            if (current->hash == hash && current->key() == key) {
+                return current;
             }
             current = current->next;
         }
-        return false; // Ключ не найден
+        if (oldTable != nullptr) {
+            size_t index = bucketIndex(hash, oldSize);
+            current = index >= rehashIndex ? oldTable[index] : nullptr;
+            while (current != nullptr) {
+                if (current->hash == hash && current->key() == key) {
+                    return current;
+                }
+                current = current->next;
+            }
+        }
+        return nullptr;
+    }
+
+    KeyValuePair* find(string_view key) const {
+        return find(key, hashFunction(key));
     }
 
-    bool del(const string& key) {
-        size_t hash = hashFunction(key);
-        KeyValuePair* current = table[hash];
+    bool unlink(KeyValuePair*& head, string_view key, uint64_t hash) {
+        KeyValuePair* current = head;
         KeyValuePair* prev = nullptr;
         while (current != nullptr) {
-            if (current->key == key) {
+            if (current->hash == hash && current->key() == key) {
                 if (prev == nullptr) {
-                    table[hash] = current->next;
+                    head = current->next;
                 } else {
                     prev->next = current->next;
                 }
-                delete current;
+                destroyPair(current);
                 return true;
             }
             prev = current;
             current = current->next;
         }
-        return false; // Ключ не найден
+        return false;
     }
 
-    // Сохранение в текстовый файл
-    void saveToFile(const string& filename) const {
-        ofstream file(filename);
+    // Обход всех пар в обоих массивах корзин
+    template <typename Func>
+    void forEachPair(Func func) const {
         for (size_t i = 0; i < tableSize; ++i) {
-            KeyValuePair* current = table[i];
-            while (current != nullptr) {
-                file << current->key << ";" << current->value << endl;
-                current = current->next;
+            for (KeyValuePair* current = table[i]; current != nullptr; current = current->next) {
+                func(current);
             }
         }
-        file.close();
+        for (size_t i = rehashIndex; i < oldSize; ++i) {
+            for (KeyValuePair* current = oldTable[i]; current != nullptr; current = current->next) {
+                func(current);
+            }
+        }
+    }
+
+    // Первый хеш корзины, следующей за index в массиве размера size;
+    // 0 - корзина последняя (конец пространства хешей)
+    static uint64_t bucketEnd(size_t index, size_t size) {
+        if (index + 1 >= size) {
+            return 0;
+        }
+        return static_cast<uint64_t>(((static_cast<unsigned __int128>(index + 1) << 64) + size - 1) / size);
     }
 
-    // Загрузка из текстового файла
-    void loadFromFile(const string& filename) {
-        ifstream file(filename);
-        string line;
-        while (getline(file, line)) {
-            size_t pos = line.find(';');
-            if (pos != string::npos) {
-                string key = line.substr(0, pos);
-                string value = line.substr(pos + 1);
-                push(key, value);
+    // Один шаг обхода: func(node) для живых узлов с хешем в [cursor, end),
+    // где end - ближайшая граница корзин обоих массивов. Возвращает end
+    template <typename Func>
+    uint64_t scanStep(uint64_t cursor, Func func) const {
+        size_t index = bucketIndex(cursor, tableSize);
+        uint64_t end = bucketEnd(index, tableSize);
+        KeyValuePair* oldHead = nullptr;
+        if (oldTable != nullptr) {
+            size_t oldIndex = bucketIndex(cursor, oldSize);
+            uint64_t oldEnd = bucketEnd(oldIndex, oldSize);
+            if (oldEnd != 0 && (end == 0 || oldEnd < end)) {
+                end = oldEnd;
             }
+            oldHead = oldIndex >= rehashIndex ? oldTable[oldIndex] : nullptr;
+        }
+        for (KeyValuePair* head : {table[index], oldHead}) {
+            for (KeyValuePair* current = head; current != nullptr; current = current->next) {
+                if (current->hash >= cursor && (end == 0 || current->hash < end) && !expired(current)) {
+                    func(current);
+                }
+            }
+        }
+        return end;
+    }
+
+    static string readWholeFile(const string& filename) {
+        ifstream file(filename, ios::binary | ios::ate);
+        if (!file) {
+            return string();
+        }
+        string content(static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        file.read(&content[0], content.size());
+        return content;
+    }
+
+    // Узлы исчезают вместе с плитами пула, обходить цепочки нужно
+    // только ради внешних буферов
+    void freeExternal(KeyValuePair** tbl, size_t size) {
+        for (size_t i = 0; i < size && externalCount > 0; ++i) {
+            for (KeyValuePair* current = tbl[i]; current != nullptr; current = current->next) {
+                if (current->external != nullptr) {
+                    delete[] current->external;
+                    --externalCount;
+                }
+            }
+        }
+    }
+
+    // Запись текстового файла в очереди загрузки, 16 байт: значение
+    // лежит через байт после ключа (см. LineScanner), а хеш при
+    // вставке считается заново, чтобы не хранить его
+    class LoadRecord {
+    public:
+        const char* data;
+        uint32_t keySize;
+        uint32_t valueSize;
+
+        string_view key() const {
+            return string_view(data, keySize);
+        }
+
+        string_view value() const {
+            return string_view(data + keySize + 1, valueSize);
+        }
+    };
+
+    // Отображение файла только для чтения; nullptr - файл пуст или недоступен
+    static void* mapFile(const string& filename, size_t& size) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat info;
+        void* mapping = nullptr;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+            } else {
+                size = info.st_size;
+                madvise(mapping, size, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        return mapping;
+    }
+
+    // func(i) для i из [0, threads); при threads == 1 без создания потоков
+    template <typename Func>
+    static void runParallel(size_t threads, Func func) {
+        if (threads == 1) {
+            func(0);
+            return;
+        }
+        vector<thread> workers;
+        for (size_t i = 1; i < threads; ++i) {
+            workers.emplace_back(func, i);
+        }
+        func(0);
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Поток загрузки, которому достаётся ключ: пространство хешей
+    // делится на threads равных отрезков. Размер таблицы для этого
+    // не нужен, поэтому записи раскладываются прямо при разборе
+    static size_t ownerOf(uint64_t hash, size_t threads) {
+        return bucketIndex(hash, threads);
+    }
+
+    // Владелец корзины - поток, в отрезок которого попадает её первый
+    // хеш. Корзина на границе отрезков содержит и хеши следующего
+    // потока; такие записи он откладывает до последовательного прохода
+    size_t bucketOwner(size_t index, size_t threads) const {
+        return ownerOf(index == 0 ? 0 : bucketEnd(index - 1, tableSize), threads);
+    }
+
+    static KeyValuePair* findInChain(KeyValuePair* current, string_view key, uint64_t hash) {
+        while (current != nullptr && !(current->hash == hash && current->key() == key)) {
+            current = current->next;
+        }
+        return current;
+    }
+
+public:
+    // Снимок таблицы на момент вызова snapshot(), только для чтения.
+    // Читать его можно из другого потока, пока владелец таблицы
+    // продолжает push/del. Снимок может пережить таблицу
+    class Snapshot {
+    private:
+        friend class HashTable;
+
+        shared_ptr<CowState> state;
+
+        Snapshot(shared_ptr<CowState> cowState) : state(move(cowState)) {}
+
+    public:
+        ~Snapshot() {
+            state->released.store(true, memory_order_release);
+        }
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        size_t getSize() const {
+            return state->count;
+        }
+
+        bool get(string_view key, string& result) const {
+            uint64_t hash = state->hasher(key, state->seed);
+            bool found = false;
+            state->visit(bucketIndex(hash, state->tableSize), [&](const KeyValuePair* current) {
+                if (!found && current->hash == hash && current->key() == key) {
+                    result = current->value();
+                    found = true;
+                }
+            });
+            return found;
+        }
+
+        // func(key, value) для каждой пары снимка
+        template <typename Func>
+        void forEachPair(Func func) const {
+            for (size_t i = 0; i < state->tableSize; ++i) {
+                state->visit(i, [&](const KeyValuePair* current) {
+                    func(current->key(), current->value());
+                });
+            }
+        }
+
+        // Тот же формат, что у HashTable::saveToFile
+        void saveToFile(const string& filename) const {
+            TextExporter file(filename);
+            if (!file.isOpen()) {
+                cerr << "Error opening file for serialization." << endl;
+                return;
+            }
+            forEachPair([&](string_view key, string_view value) {
+                file.writeField(key);
+                file.write(';');
+                file.writeField(value);
+                file.write('\n');
+            });
+            if (!file.close()) {
+                cerr << "Error writing file." << endl;
+            }
+        }
+
+        // Тот же формат, что у HashTable::saveToBinaryFile
+        void saveToBinaryFile(const string& filename) const {
+            TextExporter file(filename);
+            if (!file.isOpen()) {
+                cerr << "Error opening file for serialization." << endl;
+                return;
+            }
+            forEachPair([&](string_view key, string_view value) {
+                size_t keySize = key.size();
+                size_t valueSize = value.size();
+                file.write(string_view(reinterpret_cast<const char*>(&keySize), sizeof(keySize)));
+                file.write(key);
+                file.write(string_view(reinterpret_cast<const char*>(&valueSize), sizeof(valueSize)));
+                file.write(value);
+            });
+            if (!file.close()) {
+                cerr << "Error writing file." << endl;
+            }
+        }
+    };
+
+    // hashFunction и hashSeed задают хеш-функцию таблицы; по умолчанию
+    // fastHash, для защиты от подбора коллизий зерно можно сделать случайным.
+    // Номер корзины (hash * size >> 64), курсор scan и фильтр Блума берут
+    // старшие биты хеша: у своей функции они должны быть хорошо
+    // перемешаны. Функция со слабыми старшими битами (например, тождество
+    // на малых числах) сваливает все ключи в одну корзину.
+    // Недопустимые пороги (см. setLoadFactors) заменяются на 1.0 и 0.0
+    HashTable(size_t initialCapacity = 10, double maxLoad = 1.0, double minLoad = 0.0,
+              HashFunction hashFunction = fastHash, uint64_t hashSeed = DEFAULT_HASH_SEED)
+        : pool(sizeof(KeyValuePair), 1024, CACHE_LINE), externalCount(0), hasher(hashFunction), seed(hashSeed),
+          tableSize(initialCapacity > 0 ? initialCapacity : 1), count(0), minCapacity(tableSize),
+          maxLoadFactor(1.0), minLoadFactor(0.0), oldTable(nullptr), oldSize(0),
+          rehashIndex(0), incremental(false), rehashStep(1), bloom(nullptr), bloomStale(0),
+          wheel(nullptr), timeSource(steadyMilliseconds), iterators(0), retired(nullptr) {
+        table = allocTable(tableSize);
+        setLoadFactors(maxLoad, minLoad);
+    }
+
+    ~HashTable() {
+        detachSnapshot(); // живой снимок переживает таблицу
+        iterators = 0;
+        releaseRetired();
+        delete wheel;
+        delete bloom;
+        freeExternal(table, tableSize);
+        delete[] table;
+        if (oldTable != nullptr) {
+            freeExternal(oldTable, oldSize);
+            delete[] oldTable;
+        }
+    }
+
+    HashTable(const HashTable&) = delete;
+    HashTable& operator=(const HashTable&) = delete;
+
+    // Ёмкость под n элементов без роста по ходу вставки
+    void reserve(size_t n) {
+        finishRehash();
+        size_t needed = static_cast<size_t>(n / maxLoadFactor) + 1;
+        if (needed > tableSize) {
+            bool wasIncremental = incremental;
+            incremental = false;
+            rehash(needed);
+            incremental = wasIncremental;
+        }
+    }
+
+    // Пакетная вставка пар (first, second), приводимых к string_view.
+    // Таблица заранее расширяется под весь пакет. При unique = true
+    // вызывающий гарантирует, что ключи различны и ещё не встречаются
+    // в таблице: цепочки тогда не просматриваются вовсе
+    template <typename Pairs>
+    void pushBatch(const Pairs& items, bool unique = false) {
+        reserve(count + items.size());
+        for (const auto& item : items) {
+            bulkInsert(item.first, item.second, unique);
+        }
+    }
+
+    // Ключи принимаются как string_view: строки, char* и срезы буфера
+    // ищутся без создания временной string
+    void push(string_view key, string_view value) {
+        pushExpiring(key, value, 0);
+    }
+
+    // Вставка с временем жизни ttl миллисекунд: по его истечении get
+    // ключ не находит, а узел удаляется колесом таймеров при ближайшей
+    // операции push/del или вызове expire()
+    void push(string_view key, string_view value, uint64_t ttl) {
+        pushExpiring(key, value, timeSource() + max<uint64_t>(ttl, 1));
+    }
+
+    bool get(string_view key, string& result) const {
+        KeyValuePair* pair = find(key);
+        if (pair == nullptr) {
+            return false; // Ключ не найден
+        }
+        result = pair->value();
+        return true;
+    }
+
+    // Поиск без копирования: result указывает на значение внутри таблицы
+    // и остаётся действительным до удаления этого ключа
+    bool get(string_view key, string_view& result) const {
+        KeyValuePair* pair = find(key);
+        if (pair == nullptr) {
+            return false; // Ключ не найден
+        }
+        result = pair->value();
+        return true;
+    }
+
+    // Пакетный поиск: keys[i] -> values[i], found[i]; возвращает число найденных.
+    // Работает конвейером: ключ i хешируется и его корзина запрашивается
+    // в кэш, для ключа i - D читается уже подгруженная корзина и
+    // запрашивается первый узел цепочки, а ключ i - 2D разрешается.
+    // Промахи кэша разных ключей перекрываются, а не идут друг за другом
+    size_t multiGet(const string_view* keys, size_t n, string_view* values, bool* found) const {
+        const size_t D = MULTI_GET_DISTANCE;
+        const size_t ring = 4 * MULTI_GET_DISTANCE; // степень двойки, больше 2D
+        uint64_t hashes[ring];
+        KeyValuePair* heads[ring];
+        size_t total = 0;
+        for (size_t i = 0; i < n + 2 * D; ++i) {
+            if (i < n) {
+                hashes[i % ring] = hashFunction(keys[i]);
+                if (bloom != nullptr) {
+                    bloom->prefetch(hashes[i % ring]);
+                }
+                __builtin_prefetch(&table[bucketIndex(hashes[i % ring], tableSize)]);
+            }
+            if (i >= D && i - D < n) {
+                size_t j = (i - D) % ring;
+                bool rejected = bloom != nullptr && !bloom->mayContain(hashes[j]);
+                heads[j] = rejected ? nullptr : table[bucketIndex(hashes[j], tableSize)];
+                if (heads[j] != nullptr) {
+                    __builtin_prefetch(heads[j]);
+                }
+            }
+            if (i >= 2 * D && i - 2 * D < n) {
+                size_t k = i - 2 * D;
+                uint64_t hash = hashes[k % ring];
+                KeyValuePair* current = heads[k % ring];
+                while (current != nullptr && !(current->hash == hash && current->key() == keys[k])) {
+                    current = current->next;
+                }
+                if (current == nullptr && oldTable != nullptr) {
+                    current = find(keys[k], hash); // ключ мог ещё не переехать из старого массива
+                }
+                if (current != nullptr && expired(current)) {
+                    current = nullptr;
+                }
+                found[k] = current != nullptr;
+                if (current != nullptr) {
+                    values[k] = current->value();
+                    ++total;
+                }
+            }
+        }
+        return total;
+    }
+
+    // Итератор по парам (ключ, значение) без копирования строк. Обход
+    // идёт курсором scan, поэтому рост таблицы и постепенный перенос
+    // корзин во время обхода допустимы. Удаления (del, истечение TTL
+    // внутри push) тоже: пока жив хоть один итератор, узлы не
+    // освобождаются, но запись, удалённая после чтения её участка, ещё
+    // может быть выдана
+    class Iterator {
+    private:
+        friend class HashTable;
+
+        const HashTable* owner;
+        uint64_t cursor;
+        bool finished;
+        vector<const KeyValuePair*> batch; // узлы текущего участка
+        size_t position;
+
+        Iterator(const HashTable* table, bool atEnd)
+            : owner(table), cursor(0), finished(atEnd), position(0) {
+            ++owner->iterators;
+            fill();
+        }
+
+        void fill() {
+            batch.clear();
+            position = 0;
+            while (batch.empty() && !finished) {
+                cursor = owner->scanStep(cursor, [&](const KeyValuePair* current) {
+                    batch.push_back(current);
+                });
+                finished = cursor == 0;
+            }
+        }
+
+        bool atEnd() const {
+            return position >= batch.size();
+        }
+
+    public:
+        Iterator(const Iterator& other)
+            : owner(other.owner), cursor(other.cursor), finished(other.finished), batch(other.batch),
+              position(other.position) {
+            ++owner->iterators;
+        }
+
+        Iterator& operator=(Iterator other) {
+            std::swap(owner, other.owner); // прежний владелец отпускается деструктором other
+            std::swap(cursor, other.cursor);
+            std::swap(finished, other.finished);
+            batch.swap(other.batch);
+            std::swap(position, other.position);
+            return *this;
+        }
+
+        ~Iterator() {
+            if (--owner->iterators == 0) {
+                const_cast<HashTable*>(owner)->releaseRetired();
+            }
+        }
+
+        pair<string_view, string_view> operator*() const {
+            return {batch[position]->key(), batch[position]->value()};
+        }
+
+        Iterator& operator++() {
+            if (++position == batch.size()) {
+                fill();
+            }
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            if (atEnd() || other.atEnd()) {
+                return atEnd() == other.atEnd();
+            }
+            return batch[position] == other.batch[other.position];
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    Iterator begin() const {
+        return Iterator(this, false);
+    }
+
+    Iterator end() const {
+        return Iterator(this, true);
+    }
+
+    // Пошаговый обход, как SCAN в Redis: func(key, value) вызывается для
+    // записей очередных участков, пока их не наберётся хотя бы batch.
+    // Возвращает курсор следующего вызова; 0 - начало и конец обхода.
+    // Курсор - позиция в пространстве хешей: корзины при любом размере
+    // таблицы покрывают отрезки хешей по порядку, поэтому рост, сжатие и
+    // перенос корзин между вызовами не дают ни пропусков, ни повторов
+    // записей, существовавших весь обход
+    template <typename Func>
+    uint64_t scan(uint64_t cursor, size_t batch, Func func) const {
+        size_t yielded = 0;
+        do {
+            cursor = scanStep(cursor, [&](const KeyValuePair* current) {
+                func(current->key(), current->value());
+                ++yielded;
+            });
+        } while (cursor != 0 && yielded < batch);
+        return cursor;
+    }
+
+    bool del(string_view key) {
+        expireDue();
+        return remove(key, hashFunction(key));
+    }
+
+    // Удаление просроченных записей; возвращает их число
+    size_t expire() {
+        return expireDue();
+    }
+
+    // Источник времени для сроков жизни (по умолчанию steady_clock, мс).
+    // Сроки уже записанных TTL-записей отсчитаны по прежнему источнику и
+    // в новом не имеют смысла, поэтому при их наличии смена отклоняется
+    bool setTimeSource(TimeSource source) {
+        bool hasDeadlines = false;
+        if (wheel != nullptr) {
+            forEachPair([&](const KeyValuePair* current) {
+                hasDeadlines = hasDeadlines || current->expireAt != 0;
+            });
+        }
+        if (hasDeadlines) {
+            cerr << "Error: table has entries with TTL." << endl;
+            return false;
+        }
+        timeSource = source;
+        delete wheel; // в колесе остались только таймеры удалённых записей
+        wheel = nullptr;
+        return true;
+    }
+
+    // Записи с TTL, ещё не удалённые колесом таймеров
+    size_t getTimerCount() const {
+        return wheel != nullptr ? wheel->getSize() : 0;
+    }
+
+    // Сохранение в текстовый файл; ';', '\\' и перевод строки внутри
+    // ключей и значений экранируются (см. TextExporter)
+    void saveToFile(const string& filename) const {
+        TextExporter file(filename);
+        if (!file.isOpen()) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        uint64_t now = timeSource();
+        forEachPair([&](const KeyValuePair* current) {
+            if (expired(current, now)) {
+                return; // просроченные записи не сохраняются
+            }
+            file.writeField(current->key());
+            file.write(';');
+            file.writeField(current->value());
+            file.write('\n');
+        });
+        if (!file.close()) {
+            cerr << "Error writing file." << endl;
+        }
+    }
+
+    // Загрузка из текстового файла. trusted - ключи в файле заведомо
+    // различны, проверка дубликатов не нужна. Файл отображается в память
+    // и режется по границам строк на threads частей (0 - по числу ядер).
+    // Каждый поток разбирает свою часть и сразу раскладывает записи по
+    // потокам назначения; кроме самого файла, память нужна только под
+    // эти 16-байтные записи. Поток назначения владеет непрерывным
+    // диапазоном корзин и вставляет в него без блокировок, а узлы берёт
+    // из пула пачками под общей блокировкой, так как пул не потокобезопасен
+    void loadFromFile(const string& filename, bool trusted = false, size_t threads = 0) {
+        detachSnapshot(); // потоки загрузки пишут в корзины напрямую
+        expireDue();
+        string fallback;
+        const char* begin = nullptr;
+        size_t size = 0;
+        void* mapping = mapFile(filename, size);
+        if (mapping != nullptr) {
+            begin = static_cast<const char*>(mapping);
+        } else {
+            fallback = readWholeFile(filename);
+            begin = fallback.data();
+            size = fallback.size();
+        }
+        const char* end = begin + size;
+        if (threads == 0) {
+            threads = max<size_t>(thread::hardware_concurrency(), 1);
+        }
+        if (size < PARALLEL_LOAD_MIN) {
+            threads = 1;
+        }
+
+        // Разбор: записи части t раскладываются в routed[t][p] по отрезкам хешей
+        vector<const char*> bounds(threads + 1, end);
+        bounds[0] = begin;
+        for (size_t t = 1; t < threads; ++t) {
+            bounds[t] = LineScanner::nextLine(max(begin + size / threads * t, bounds[t - 1]), end);
+        }
+        // Сканеры живут до конца загрузки: в них хранятся строки,
+        // восстановленные из экранированных записей
+        vector<LineScanner> scanners;
+        for (size_t t = 0; t < threads; ++t) {
+            scanners.emplace_back(bounds[t], bounds[t + 1]);
+        }
+        vector<vector<vector<LoadRecord>>> routed(threads, vector<vector<LoadRecord>>(threads));
+        runParallel(threads, [&](size_t t) {
+            string_view key, value;
+            while (scanners[t].next(key, value)) {
+                LoadRecord record = {key.data(), static_cast<uint32_t>(key.size()),
+                                     static_cast<uint32_t>(value.size())};
+                routed[t][ownerOf(hashFunction(key), threads)].push_back(record);
+            }
+        });
+        size_t total = 0;
+        for (const vector<vector<LoadRecord>>& part : routed) {
+            for (const vector<LoadRecord>& records : part) {
+                total += records.size();
+            }
+        }
+        reserve(count + total);
+
+        // Вставка: поток p получает записи своего отрезка из всех частей
+        // в порядке файла, поэтому из повторов остаётся первый
+        mutex poolLock;
+        vector<vector<void*>> spare(threads); // узлы, взятые из пула и ещё не занятые
+        vector<vector<LoadRecord>> deferred(threads);
+        vector<size_t> inserted(threads, 0);
+        vector<size_t> external(threads, 0);
+        vector<size_t> duplicates(threads, 0);
+        runParallel(threads, [&](size_t p) {
+            for (size_t t = 0; t < threads; ++t) {
+                for (const LoadRecord& record : routed[t][p]) {
+                    uint64_t hash = hashFunction(record.key());
+                    size_t index = bucketIndex(hash, tableSize);
+                    if (bucketOwner(index, threads) != p) {
+                        deferred[p].push_back(record);
+                        continue;
+                    }
+                    KeyValuePair*& head = table[index];
+                    if (!trusted && findInChain(head, record.key(), hash) != nullptr) {
+                        ++duplicates[p];
+                        continue;
+                    }
+                    if (spare[p].empty()) {
+                        lock_guard<mutex> guard(poolLock);
+                        for (size_t i = 0; i < LOAD_BLOCKS; ++i) {
+                            spare[p].push_back(pool.allocate());
+                        }
+                    }
+                    KeyValuePair* pair = initPair(spare[p].back(), record.key(), record.value(), hash);
+                    spare[p].pop_back();
+                    external[p] += pair->external != nullptr;
+                    pair->next = head;
+                    head = pair;
+                    ++inserted[p];
+                }
+                vector<LoadRecord>().swap(routed[t][p]);
+            }
+        });
+        size_t skipped = 0;
+        for (size_t p = 0; p < threads; ++p) {
+            count += inserted[p];
+            externalCount += external[p];
+            skipped += duplicates[p];
+            for (void* block : spare[p]) {
+                pool.release(block);
+            }
+            // Отложенные записи граничных корзин; повторы ключа всегда
+            // откладываются вместе, порядок файла сохраняется
+            for (const LoadRecord& record : deferred[p]) {
+                uint64_t hash = hashFunction(record.key());
+                KeyValuePair*& head = table[bucketIndex(hash, tableSize)];
+                if (!trusted && findInChain(head, record.key(), hash) != nullptr) {
+                    ++skipped;
+                    continue;
+                }
+                KeyValuePair* pair = createPair(record.key(), record.value(), hash);
+                pair->next = head;
+                head = pair;
+                ++count;
+            }
+        }
+        for (size_t i = 0; i < skipped; ++i) {
+            cout << "6:ERROR: Key already exists." << endl;
+        }
+        if (bloom != nullptr) {
+            fillBloomFilter(max(bloom->getExpectedKeys(), count));
+        }
+        if (mapping != nullptr) {
+            munmap(mapping, size);
         }
-        file.close();
     }
 
     // Сохранение в бинарный файл
     void saveToBinaryFile(const string& filename) const {
         ofstream file(filename, ios::binary);
-        for (size_t i = 0; i < tableSize; ++i) {
-            KeyValuePair* current = table[i];
-            while (current != nullptr) {
-                size_t keySize = current->key.size();
-                size_t valueSize = current->value.size();
-                file.write(reinterpret_cast<char*>(&keySize), sizeof(keySize));
-                file.write(current->key.c_str(), keySize);
-                file.write(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
-                file.write(current->value.c_str(), valueSize);
-                current = current->next;
+        uint64_t now = timeSource();
+        forEachPair([&](const KeyValuePair* current) {
+            if (expired(current, now)) {
+                return;
             }
-        }
+            size_t keySize = current->keySize;
+            size_t valueSize = current->valueSize;
+            file.write(reinterpret_cast<char*>(&keySize), sizeof(keySize));
+            file.write(current->data(), keySize);
+            file.write(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
+            file.write(current->data() + keySize, valueSize);
+        });
         file.close();
     }
 
-    // Загрузка из бинарного файла
-    void loadFromBinaryFile(const string& filename) {
-        ifstream file(filename, ios::binary);
-        while (file) {
-            size_t keySize, valueSize;
-            if (!file.read(reinterpret_cast<char*>(&keySize), sizeof(keySize))) break;
+    // Загрузка из бинарного файла: файл отображается в память, и записи
+    // вставляются прямо из отображения, без копии файла и без списка
+    // записей; таблица растёт по ходу вставки. trusted - как в pushBatch
+    void loadFromBinaryFile(const string& filename, bool trusted = false) {
+        string fallback;
+        size_t size = 0;
+        void* mapping = mapFile(filename, size);
+        const char* content = static_cast<const char*>(mapping);
+        if (mapping == nullptr) {
+            fallback = readWholeFile(filename);
+            content = fallback.data();
+            size = fallback.size();
+        }
+        size_t pos = 0;
+        size_t keySize, valueSize;
+        while (size - pos >= sizeof(keySize)) {
+            memcpy(&keySize, content + pos, sizeof(keySize));
+            pos += sizeof(keySize);
+            if (size - pos < keySize) break;
+            string_view key(content + pos, keySize);
+            pos += keySize;
+            if (size - pos < sizeof(valueSize)) break;
+            memcpy(&valueSize, content + pos, sizeof(valueSize));
+            pos += sizeof(valueSize);
+            if (size - pos < valueSize) break;
+            if (oldTable != nullptr) {
+                migrate(rehashStep);
+            }
+            bulkInsert(key, string_view(content + pos, valueSize), trusted);
+            pos += valueSize;
+        }
+        if (mapping != nullptr) {
+            munmap(mapping, size);
+        }
+    }
+
+    // Сохранение снимка с индексом корзин (формат описан в mapped_hash_table.h).
+    // MappedHashTable обслуживает такой файл прямо из отображения в память
+    bool saveSnapshot(const string& filename) const {
+        ofstream file(filename, ios::binary);
+        if (!file) {
+            cerr << "Error opening file for snapshot." << endl;
+            return false;
+        }
+        // Просроченные записи в снимок не попадают; время фиксируется
+        // один раз, чтобы все проходы видели один и тот же набор записей
+        uint64_t now = timeSource();
+        uint64_t live = 0;
+        forEachPair([&](const KeyValuePair* current) {
+            live += !expired(current, now);
+        });
+        uint64_t bucketCount = 1;
+        while (bucketCount < live) {
+            bucketCount *= 2;
+        }
+        // Подсчёт записей по корзинам и префиксные суммы
+        vector<uint64_t> hashes;
+        hashes.reserve(live);
+        vector<uint64_t> bucketStart(bucketCount + 1, 0);
+        // Снимок всегда индексируется fastHash с зерном таблицы; если таблица
+        // использует его же, берутся хеши, сохранённые в узлах
+        bool cachedHash = hasher == fastHash;
+        forEachPair([&](const KeyValuePair* current) {
+            if (expired(current, now)) {
+                return;
+            }
+            uint64_t hash = cachedHash ? current->hash : fastHash(current->key(), seed);
+            hashes.push_back(hash);
+            ++bucketStart[(hash & (bucketCount - 1)) + 1];
+        });
+        for (uint64_t i = 0; i < bucketCount; ++i) {
+            bucketStart[i + 1] += bucketStart[i];
+        }
 
-            string key(keySize, '\0');
-            file.read(&key[0], keySize);
+        SnapshotHeader header = {};
+        memcpy(header.magic, SnapshotHeader::MAGIC, sizeof(header.magic));
+        header.count = live;
+        header.hashSeed = seed;
+        header.bucketCount = bucketCount;
+        header.bucketsOffset = sizeof(SnapshotHeader);
+        header.entriesOffset = header.bucketsOffset + (bucketCount + 1) * sizeof(uint64_t);
+        // Фильтр снимка строится заново по хешам снимка и выравнивается
+        // по кэш-линии
+        BloomFilter* snapshotBloom = nullptr;
+        if (bloom != nullptr) {
+            snapshotBloom = new BloomFilter(live);
+            for (uint64_t hash : hashes) {
+                snapshotBloom->add(hash);
+            }
+            header.bloomBlocks = snapshotBloom->getBlockCount();
+            header.bloomOffset = (header.entriesOffset + BloomFilter::blockBytes() - 1)
+                / BloomFilter::blockBytes() * BloomFilter::blockBytes();
+            header.entriesOffset = header.bloomOffset + header.bloomBlocks * BloomFilter::blockBytes();
+        }
+        header.dataOffset = header.entriesOffset + live * sizeof(SnapshotEntry);
 
-            file.read(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
-            string value(valueSize, '\0');
-            file.read(&value[0], valueSize);
+        vector<SnapshotEntry> entries(live);
+        vector<uint64_t> next(bucketStart.begin(), bucketStart.end() - 1);
+        uint64_t offset = header.dataOffset;
+        size_t index = 0;
+        forEachPair([&](const KeyValuePair* current) {
+            if (expired(current, now)) {
+                return;
+            }
+            uint64_t hash = hashes[index++];
+            SnapshotEntry& entry = entries[next[hash & (bucketCount - 1)]++];
+            entry.hash = hash;
+            entry.keyOffset = offset;
+            entry.keySize = current->keySize;
+            entry.valueSize = current->valueSize;
+            offset += current->keySize + current->valueSize;
+        });
+        header.fileSize = offset;
 
-            push(key, value);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(bucketStart.data()), bucketStart.size() * sizeof(uint64_t));
+        if (snapshotBloom != nullptr) {
+            uint64_t written = header.bucketsOffset + bucketStart.size() * sizeof(uint64_t);
+            string padding(header.bloomOffset - written, '\0');
+            file.write(padding.data(), padding.size());
+            file.write(reinterpret_cast<const char*>(snapshotBloom->data()),
+                       header.bloomBlocks * BloomFilter::blockBytes());
+            delete snapshotBloom;
         }
+        file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(SnapshotEntry));
+        forEachPair([&](const KeyValuePair* current) {
+            if (expired(current, now)) {
+                return;
+            }
+            file.write(current->data(), current->keySize + current->valueSize);
+        });
         file.close();
+        return static_cast<bool>(file);
     }
 
     size_t getCapacity() const {
         return tableSize;
     }
+
+    uint64_t getHashSeed() const {
+        return seed;
+    }
+
+    size_t getSize() const {
+        return count;
+    }
+
+    double getLoadFactor() const {
+        return static_cast<double>(count) / tableSize;
+    }
+
+    // Пороги заполненности: при превышении max таблица растёт вдвое,
+    // при падении ниже min (если min > 0) - сжимается вдвое. Нужно
+    // 0 < max и 0 <= min < max / 2: иначе рост или сжатие сразу же
+    // переходит через второй порог и таблица меняет размер на каждой
+    // операции. Недопустимые пороги отклоняются
+    bool setLoadFactors(double maxLoad, double minLoad = 0.0) {
+        if (!(maxLoad > 0.0 && minLoad >= 0.0 && minLoad < maxLoad / 2)) {
+            cerr << "Error: invalid load factors." << endl;
+            return false;
+        }
+        maxLoadFactor = maxLoad;
+        minLoadFactor = minLoad;
+        growIfNeeded();
+        shrinkIfNeeded();
+        return true;
+    }
+
+    // Постепенный рехеш: старый и новый массивы живут одновременно, а push/del
+    // переносят не более bucketsPerStep цепочек, так что ни одна операция
+    // не платит за всю миграцию целиком
+    void setIncrementalRehash(bool enabled, size_t bucketsPerStep = 1) {
+        incremental = enabled;
+        rehashStep = bucketsPerStep > 0 ? bucketsPerStep : 1;
+        if (!incremental) {
+            finishRehash();
+        }
+    }
+
+    // Снимок за O(число корзин) без копирования узлов: узлы копируются
+    // позже, по одной корзине перед её первым изменением. Одновременно
+    // жив только один снимок, повторный вызов возвращает nullptr.
+    // Незаконченный постепенный рехеш завершается сразу. В таблице
+    // с TTL добавляется проход по узлам: снимок считает только записи,
+    // живые на момент вызова
+    unique_ptr<Snapshot> snapshot() {
+        if (snapshotActive()) {
+            cerr << "Error: snapshot already exists." << endl;
+            return nullptr;
+        }
+        finishRehash();
+        uint64_t now = timeSource();
+        size_t live = count;
+        if (wheel != nullptr) {
+            forEachPair([&](const KeyValuePair* current) {
+                live -= expired(current, now); // просроченные, но ещё не удалённые
+            });
+        }
+        cow = make_shared<CowState>(table, tableSize, live, now, hasher, seed);
+        return unique_ptr<Snapshot>(new Snapshot(cow));
+    }
+
+    bool isRehashing() const {
+        return oldTable != nullptr;
+    }
+
+    // Фильтр Блума, рассчитанный на expectedKeys ключей (не меньше текущего
+    // количества). Фильтр растёт вместе с таблицей и перестраивается
+    // после множества удалений; rebuildBloomFilter делает это сразу
+    void enableBloomFilter(size_t expectedKeys = 0) {
+        fillBloomFilter(max(expectedKeys, count));
+    }
+
+    void disableBloomFilter() {
+        delete bloom;
+        bloom = nullptr;
+        bloomStale = 0;
+    }
+
+    void rebuildBloomFilter() {
+        if (bloom != nullptr) {
+            fillBloomFilter(max(bloom->getExpectedKeys(), count));
+        }
+    }
+
+    bool hasBloomFilter() const {
+        return bloom != nullptr;
+    }
+
+    // Количество плит пула узлов
+    size_t getSlabCount() const {
+        return pool.getSlabCount();
+    }
 };
 
 #endif // HASH_TABLE_H_INCLUDED
@@ -6,6 +6,7 @@
 #include <iomanip>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <sstream>
 
 using namespace std;
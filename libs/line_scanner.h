@@ -0,0 +1,125 @@
+#ifndef LINE_SCANNER_H_INCLUDED
+#define LINE_SCANNER_H_INCLUDED
+
+#include "includes.h"
+#include <cstdint>
+#include <cstring>
+#include <deque>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Разбор текста вида "key;value\n" без копирования: ключ и значение
+// возвращаются срезами исходного буфера. Разделители ищутся по 16 байт
+// за раз: одно сравнение SSE2 даёт маску переводов строк, другое - маску
+// ';', третье - маску '\'. Ключ - всё до первой ';' строки, значение -
+// остаток строки. Строки с '\' (экранирование TextExporter) разбираются
+// побайтно, а восстановленные ключ и значение хранятся в самом сканере
+// и живут, пока он существует. В обоих случаях значение начинается
+// ровно через байт после конца ключа, так что запись описывается
+// указателем на ключ и двумя длинами.
+class LineScanner {
+private:
+    const char* pos;
+    const char* end;
+    deque<string> unescaped;
+
+    // Маски '\n', ';' и '\' для n <= 16 байт, начиная с p
+    static void masks(const char* p, size_t n, uint32_t& newlines, uint32_t& separators, uint32_t& escapes) {
+#ifdef __SSE2__
+        if (n == 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            newlines = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))));
+            separators = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(';'))));
+            escapes = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))));
+            return;
+        }
+#endif
+        newlines = separators = escapes = 0;
+        for (size_t i = 0; i < n; ++i) {
+            newlines |= static_cast<uint32_t>(p[i] == '\n') << i;
+            separators |= static_cast<uint32_t>(p[i] == ';') << i;
+            escapes |= static_cast<uint32_t>(p[i] == '\\') << i;
+        }
+    }
+
+    // Разбор строки [begin, finish) с экранированием: ключ до первой
+    // неэкранированной ';', "\n" - перевод строки, "\x" - символ x
+    bool parseEscaped(const char* begin, const char* finish, string_view& key, string_view& value) {
+        string parsedKey;
+        string parsedValue;
+        string* current = &parsedKey;
+        bool separated = false;
+        for (const char* p = begin; p < finish; ++p) {
+            if (*p == '\\' && p + 1 < finish) {
+                ++p;
+                current->push_back(*p == 'n' ? '\n' : *p);
+            } else if (*p == ';' && !separated) {
+                separated = true;
+                current = &parsedValue;
+            } else {
+                current->push_back(*p);
+            }
+        }
+        if (!separated) {
+            return false;
+        }
+        // Ключ, ';' и значение подряд, как в неэкранированной строке
+        size_t keySize = parsedKey.size();
+        parsedKey.push_back(';');
+        parsedKey += parsedValue;
+        unescaped.push_back(move(parsedKey));
+        key = string_view(unescaped.back().data(), keySize);
+        value = string_view(unescaped.back().data() + keySize + 1, parsedValue.size());
+        return true;
+    }
+
+public:
+    LineScanner(const char* begin, const char* finish) : pos(begin), end(finish) {}
+
+    // Следующая строка с ';'; строки без разделителя пропускаются
+    bool next(string_view& key, string_view& value) {
+        while (pos < end) {
+            const char* lineStart = pos;
+            const char* lineEnd = end;
+            const char* separator = nullptr;
+            bool escaped = false;
+            for (const char* p = pos; p < end; p += 16) {
+                uint32_t newlines, separators, escapes;
+                masks(p, min<size_t>(16, end - p), newlines, separators, escapes);
+                // Учитываются только символы до конца строки
+                uint32_t inLine = newlines != 0 ? (newlines & -newlines) - 1 : 0xFFFF;
+                escaped = escaped || (escapes & inLine) != 0;
+                if (separator == nullptr && (separators & inLine) != 0) {
+                    separator = p + __builtin_ctz(separators & inLine);
+                }
+                if (newlines != 0) {
+                    lineEnd = p + __builtin_ctz(newlines);
+                    break;
+                }
+            }
+            pos = lineEnd < end ? lineEnd + 1 : end;
+            if (escaped) {
+                if (parseEscaped(lineStart, lineEnd, key, value)) {
+                    return true;
+                }
+                continue;
+            }
+            if (separator != nullptr) {
+                key = string_view(lineStart, separator - lineStart);
+                value = string_view(separator + 1, lineEnd - separator - 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Начало строки, следующей за позицией p (или конец буфера)
+    static const char* nextLine(const char* p, const char* finish) {
+        const char* newline = static_cast<const char*>(memchr(p, '\n', finish - p));
+        return newline != nullptr ? newline + 1 : finish;
+    }
+};
+
+#endif // LINE_SCANNER_H_INCLUDED
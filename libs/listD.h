@@ -2,6 +2,7 @@
 #define LISTD_H_INCLUDED
 
 #include "includes.h"
+#include "exporter.h"
 
 class ListD {
 private:
@@ -122,16 +123,22 @@ public:
     }
 
     void saveToFile(const string& filename) {
-        ofstream file(filename);
+        TextExporter file(filename);
+        if (!file.isOpen()) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
         Node* current = head;
         while (current != nullptr) {
-            file << current->data;
+            file.writeField(current->data);
             if (current->next != nullptr) {
-                file << ";";
+                file.write(';');
             }
             current = current->next;
         }
-        file.close();
+        if (!file.close()) {
+            cerr << "Error writing file." << endl;
+        }
     }
 
     void saveToBinaryFile(const string& filename) {
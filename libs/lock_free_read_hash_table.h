@@ -0,0 +1,367 @@
+#ifndef LOCK_FREE_READ_HASH_TABLE_H_INCLUDED
+#define LOCK_FREE_READ_HASH_TABLE_H_INCLUDED
+
+#include "includes.h"
+#include "hash_function.h"
+#include "exporter.h"
+#include "line_scanner.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Хеш-таблица для нагрузки, где почти все операции - чтения.
+// get не берёт блокировок и не выполняет атомарных read-modify-write:
+// читатель лишь объявляет текущую эпоху в собственной ячейке.
+// Писатели упорядочены мьютексом, публикуют узлы атомарной записью
+// указателя, а удалённые узлы освобождают только после того, как все
+// читатели покинули эпоху, в которой узел ещё был доступен.
+class LockFreeReadHashTable {
+private:
+    class KeyValuePair {
+    public:
+        const string key;
+        const string value;
+        atomic<KeyValuePair*> next;
+
+        KeyValuePair(string_view k, string_view v) : key(k), value(v), next(nullptr) {}
+    };
+
+    // Массив корзин публикуется целиком: при росте строится новый,
+    // а старый вместе со своими узлами уходит на отложенное освобождение
+    class Buckets {
+    public:
+        size_t size; // степень двойки
+        atomic<KeyValuePair*>* heads;
+
+        Buckets(size_t s) : size(s), heads(new atomic<KeyValuePair*>[s]) {
+            for (size_t i = 0; i < size; ++i) {
+                heads[i].store(nullptr, memory_order_relaxed);
+            }
+        }
+
+        // Массив корзин владеет своими цепочками
+        ~Buckets() {
+            for (size_t i = 0; i < size; ++i) {
+                KeyValuePair* current = heads[i].load(memory_order_relaxed);
+                while (current != nullptr) {
+                    KeyValuePair* next = current->next.load(memory_order_relaxed);
+                    delete current;
+                    current = next;
+                }
+            }
+            delete[] heads;
+        }
+    };
+
+    // Ячейка читателя: эпоха, в которой он сейчас читает, или 0
+    class alignas(64) ReaderSlot {
+    public:
+        atomic<uint64_t> epoch{0};
+    };
+
+    // Номера ячеек раздаются потокам один раз и возвращаются при их завершении
+    class ReaderRegistry {
+    public:
+        mutex lock;
+        vector<size_t> freeIds;
+        size_t nextId = 0;
+    };
+
+    class ReaderToken {
+    public:
+        size_t id;
+
+        ReaderToken() {
+            ReaderRegistry& registry = readerRegistry();
+            lock_guard<mutex> guard(registry.lock);
+            if (registry.freeIds.empty()) {
+                id = registry.nextId++;
+            } else {
+                id = registry.freeIds.back();
+                registry.freeIds.pop_back();
+            }
+        }
+
+        ~ReaderToken() {
+            ReaderRegistry& registry = readerRegistry();
+            lock_guard<mutex> guard(registry.lock);
+            registry.freeIds.push_back(id);
+        }
+    };
+
+    class Retired {
+    public:
+        uint64_t epoch;
+        KeyValuePair* node;
+        Buckets* buckets;
+    };
+
+    static constexpr size_t MAX_READERS = 128;
+    static constexpr size_t RECLAIM_BATCH = 64;
+
+    atomic<Buckets*> buckets;
+    size_t count;
+    mutable mutex writeLock;
+    atomic<uint64_t> globalEpoch;
+    mutable ReaderSlot readers[MAX_READERS];
+    vector<Retired> retired;
+    size_t reclaimAt; // размер списка, при котором пора освобождать
+
+    static ReaderRegistry& readerRegistry() {
+        static ReaderRegistry registry;
+        return registry;
+    }
+
+    static size_t readerId() {
+        thread_local ReaderToken token;
+        return token.id;
+    }
+
+    static size_t hashFunction(string_view key) {
+        return fastHash(key);
+    }
+
+    static KeyValuePair* findIn(const Buckets* b, string_view key) {
+        KeyValuePair* current = b->heads[hashFunction(key) & (b->size - 1)].load(memory_order_acquire);
+        while (current != nullptr) {
+            if (current->key == key) {
+                return current;
+            }
+            current = current->next.load(memory_order_acquire);
+        }
+        return nullptr;
+    }
+
+    // Эпоха может сдвинуться, только если каждый активный читатель
+    // уже находится в текущей. Узлы, снятые две эпохи назад и раньше,
+    // не видны ни одному читателю
+    void tryReclaim() {
+        uint64_t current = globalEpoch.load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        bool canAdvance = true;
+        for (size_t i = 0; i < MAX_READERS; ++i) {
+            uint64_t epoch = readers[i].epoch.load(memory_order_acquire);
+            if (epoch != 0 && epoch != current) {
+                canAdvance = false;
+                break;
+            }
+        }
+        if (canAdvance) {
+            globalEpoch.store(++current, memory_order_release);
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); ++i) {
+            if (retired[i].epoch + 2 <= current) {
+                delete retired[i].node;
+                delete retired[i].buckets;
+            } else {
+                retired[kept++] = retired[i];
+            }
+        }
+        retired.resize(kept);
+        // Если читатель надолго задержался в эпохе, список не уменьшается,
+        // и следующая попытка откладывается, чтобы не сканировать его на каждом del
+        reclaimAt = max(RECLAIM_BATCH, kept * 2);
+    }
+
+    void retire(KeyValuePair* node, Buckets* b) {
+        retired.push_back({globalEpoch.load(memory_order_relaxed), node, b});
+        if (retired.size() >= reclaimAt) {
+            tryReclaim();
+        }
+    }
+
+    // Рост копирует узлы в новый массив: перецеплять старые нельзя,
+    // по ним в этот момент могут идти читатели. Старый массив снимается
+    // целиком вместе с цепочками
+    void grow() {
+        Buckets* old = buckets.load(memory_order_relaxed);
+        Buckets* fresh = new Buckets(old->size * 2);
+        for (size_t i = 0; i < old->size; ++i) {
+            KeyValuePair* current = old->heads[i].load(memory_order_relaxed);
+            while (current != nullptr) {
+                KeyValuePair* copy = new KeyValuePair(current->key, current->value);
+                atomic<KeyValuePair*>& head = fresh->heads[hashFunction(copy->key) & (fresh->size - 1)];
+                copy->next.store(head.load(memory_order_relaxed), memory_order_relaxed);
+                head.store(copy, memory_order_relaxed);
+                current = current->next.load(memory_order_relaxed);
+            }
+        }
+        buckets.store(fresh, memory_order_release);
+        retire(nullptr, old);
+    }
+
+    template <typename Func>
+    void forEachPair(Func func) const {
+        const Buckets* b = buckets.load(memory_order_acquire);
+        for (size_t i = 0; i < b->size; ++i) {
+            KeyValuePair* current = b->heads[i].load(memory_order_acquire);
+            while (current != nullptr) {
+                func(current);
+                current = current->next.load(memory_order_acquire);
+            }
+        }
+    }
+
+public:
+    LockFreeReadHashTable(size_t initialCapacity = 16)
+        : count(0), globalEpoch(1), reclaimAt(RECLAIM_BATCH) {
+        size_t size = 1;
+        while (size < initialCapacity) {
+            size *= 2;
+        }
+        buckets.store(new Buckets(size), memory_order_relaxed);
+    }
+
+    // Деструктор вызывается, когда читателей у таблицы больше нет
+    ~LockFreeReadHashTable() {
+        for (const Retired& item : retired) {
+            delete item.node;
+            delete item.buckets;
+        }
+        delete buckets.load(memory_order_relaxed);
+    }
+
+    LockFreeReadHashTable(const LockFreeReadHashTable&) = delete;
+    LockFreeReadHashTable& operator=(const LockFreeReadHashTable&) = delete;
+
+    void push(string_view key, string_view value) {
+        lock_guard<mutex> guard(writeLock);
+        Buckets* b = buckets.load(memory_order_relaxed);
+        if (findIn(b, key) != nullptr) {
+            cout << "6:ERROR: Key already exists." << endl;
+            return;
+        }
+        KeyValuePair* newPair = new KeyValuePair(key, value);
+        atomic<KeyValuePair*>& head = b->heads[hashFunction(key) & (b->size - 1)];
+        newPair->next.store(head.load(memory_order_relaxed), memory_order_relaxed);
+        head.store(newPair, memory_order_release); // узел виден читателям только целиком
+        if (++count > b->size) {
+            grow();
+        }
+    }
+
+    // Чтение без блокировок; значение копируется, пока эпоха объявлена
+    bool get(string_view key, string& result) const {
+        size_t id = readerId();
+        if (id >= MAX_READERS) {
+            // Потоков больше, чем ячеек: такой читатель идёт через мьютекс писателей
+            lock_guard<mutex> guard(writeLock);
+            KeyValuePair* pair = findIn(buckets.load(memory_order_relaxed), key);
+            if (pair != nullptr) {
+                result = pair->value;
+            }
+            return pair != nullptr;
+        }
+        ReaderSlot& slot = readers[id];
+        slot.epoch.store(globalEpoch.load(memory_order_acquire), memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst); // объявление эпохи видно раньше чтения узлов
+        KeyValuePair* pair = findIn(buckets.load(memory_order_acquire), key);
+        if (pair != nullptr) {
+            result = pair->value;
+        }
+        slot.epoch.store(0, memory_order_release);
+        return pair != nullptr;
+    }
+
+    bool del(string_view key) {
+        lock_guard<mutex> guard(writeLock);
+        Buckets* b = buckets.load(memory_order_relaxed);
+        atomic<KeyValuePair*>* link = &b->heads[hashFunction(key) & (b->size - 1)];
+        KeyValuePair* current = link->load(memory_order_relaxed);
+        while (current != nullptr) {
+            if (current->key == key) {
+                // Читатель, стоящий на current, по-прежнему видит его next
+                link->store(current->next.load(memory_order_relaxed), memory_order_release);
+                retire(current, nullptr);
+                --count;
+                return true;
+            }
+            link = &current->next;
+            current = link->load(memory_order_relaxed);
+        }
+        return false; // Ключ не найден
+    }
+
+    // Сохранение в текстовый файл; писатели ждут, читатели - нет
+    void saveToFile(const string& filename) const {
+        lock_guard<mutex> guard(writeLock);
+        TextExporter file(filename);
+        if (!file.isOpen()) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        forEachPair([&](const KeyValuePair* current) {
+            file.writeField(current->key);
+            file.write(';');
+            file.writeField(current->value);
+            file.write('\n');
+        });
+        if (!file.close()) {
+            cerr << "Error writing file." << endl;
+        }
+    }
+
+    // Загрузка из текстового файла
+    void loadFromFile(const string& filename) {
+        ifstream file(filename, ios::binary);
+        string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        LineScanner scanner(content.data(), content.data() + content.size());
+        string_view key, value;
+        while (scanner.next(key, value)) {
+            push(key, value);
+        }
+    }
+
+    // Сохранение в бинарный файл
+    void saveToBinaryFile(const string& filename) const {
+        lock_guard<mutex> guard(writeLock);
+        ofstream file(filename, ios::binary);
+        forEachPair([&](const KeyValuePair* current) {
+            size_t keySize = current->key.size();
+            size_t valueSize = current->value.size();
+            file.write(reinterpret_cast<char*>(&keySize), sizeof(keySize));
+            file.write(current->key.c_str(), keySize);
+            file.write(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
+            file.write(current->value.c_str(), valueSize);
+        });
+        file.close();
+    }
+
+    // Загрузка из бинарного файла
+    void loadFromBinaryFile(const string& filename) {
+        ifstream file(filename, ios::binary);
+        while (file) {
+            size_t keySize, valueSize;
+            if (!file.read(reinterpret_cast<char*>(&keySize), sizeof(keySize))) break;
+
+            string key(keySize, '\0');
+            file.read(&key[0], keySize);
+
+            file.read(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
+            string value(valueSize, '\0');
+            file.read(&value[0], valueSize);
+
+            push(key, value);
+        }
+        file.close();
+    }
+
+    size_t getCapacity() const {
+        return buckets.load(memory_order_acquire)->size;
+    }
+
+    size_t getSize() const {
+        lock_guard<mutex> guard(writeLock);
+        return count;
+    }
+
+    // Количество снятых узлов, ещё ожидающих освобождения
+    size_t getRetiredCount() const {
+        lock_guard<mutex> guard(writeLock);
+        return retired.size();
+    }
+};
+
+#endif // LOCK_FREE_READ_HASH_TABLE_H_INCLUDED
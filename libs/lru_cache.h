@@ -0,0 +1,195 @@
+#ifndef LRU_CACHE_H_INCLUDED
+#define LRU_CACHE_H_INCLUDED
+
+#include "includes.h"
+#include "hash_table.h"
+#include <cstdint>
+
+// Кэш с ограничением по объёму поверх HashTable. Занятый объём -
+// сумма длин ключей и значений; при превышении бюджета вытесняются
+// давно не использованные записи. Порядок использования хранится
+// двусвязным списком, ссылки которого лежат прямо в узлах таблицы
+// (сразу за KeyValuePair), поэтому обращение, вставка и вытеснение
+// стоят O(1) и не требуют отдельных выделений памяти.
+class LRUCache {
+private:
+    using Node = HashTable::KeyValuePair;
+
+    class Links {
+    public:
+        Node* prev; // к более свежим записям
+        Node* next; // к более старым записям
+    };
+
+    HashTable table;
+    Node* head; // самая свежая запись
+    Node* tail; // кандидат на вытеснение
+    size_t byteBudget;
+    size_t usedBytes;
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+
+    static Links& links(Node* node) {
+        return *static_cast<Links*>(HashTable::nodeExtra(node));
+    }
+
+    static size_t charge(const Node* node) {
+        return static_cast<size_t>(node->keySize) + node->valueSize;
+    }
+
+    void unlinkNode(Node* node) {
+        Links& link = links(node);
+        if (link.prev != nullptr) {
+            links(link.prev).next = link.next;
+        } else {
+            head = link.next;
+        }
+        if (link.next != nullptr) {
+            links(link.next).prev = link.prev;
+        } else {
+            tail = link.prev;
+        }
+    }
+
+    void pushFront(Node* node) {
+        Links& link = links(node);
+        link.prev = nullptr;
+        link.next = head;
+        if (head != nullptr) {
+            links(head).prev = node;
+        }
+        head = node;
+        if (tail == nullptr) {
+            tail = node;
+        }
+    }
+
+    // Удаление узла из списка и таблицы; хеш берётся из узла
+    void removeNode(Node* node) {
+        unlinkNode(node);
+        usedBytes -= charge(node);
+        table.remove(node->key(), node->hash);
+    }
+
+    void evictTo(size_t budget) {
+        while (usedBytes > budget && tail != nullptr) {
+            removeNode(tail);
+            ++evictions;
+        }
+    }
+
+    // Поиск с учётом статистики; найденная запись становится самой свежей
+    Node* touch(string_view key) {
+        Node* node = table.find(key);
+        if (node == nullptr) {
+            ++misses;
+            return nullptr;
+        }
+        ++hits;
+        if (node != head) {
+            unlinkNode(node);
+            pushFront(node);
+        }
+        return node;
+    }
+
+public:
+    LRUCache(size_t budget, size_t initialCapacity = 10)
+        : table(initialCapacity), head(nullptr), tail(nullptr), byteBudget(budget), usedBytes(0),
+          hits(0), misses(0), evictions(0) {
+        table.setNodeExtra(sizeof(Links));
+    }
+
+    LRUCache(const LRUCache&) = delete;
+    LRUCache& operator=(const LRUCache&) = delete;
+
+    // Вставка или замена значения. Запись больше всего бюджета
+    // не сохраняется: возвращается false
+    bool put(string_view key, string_view value) {
+        uint64_t hash = table.hashFunction(key);
+        Node* old = table.find(key, hash);
+        if (old != nullptr) {
+            removeNode(old);
+        }
+        size_t size = key.size() + value.size();
+        if (size > byteBudget) {
+            return false;
+        }
+        evictTo(byteBudget - size);
+        pushFront(table.insert(key, value, hash));
+        usedBytes += size;
+        return true;
+    }
+
+    bool get(string_view key, string& result) {
+        Node* node = touch(key);
+        if (node == nullptr) {
+            return false; // Ключ не найден
+        }
+        result = node->value();
+        return true;
+    }
+
+    // result указывает внутрь кэша и действителен до вытеснения
+    // или удаления этого ключа
+    bool get(string_view key, string_view& result) {
+        Node* node = touch(key);
+        if (node == nullptr) {
+            return false; // Ключ не найден
+        }
+        result = node->value();
+        return true;
+    }
+
+    // Проверка наличия без изменения порядка и статистики
+    bool contains(string_view key) const {
+        return table.find(key) != nullptr;
+    }
+
+    bool del(string_view key) {
+        Node* node = table.find(key);
+        if (node == nullptr) {
+            return false; // Ключ не найден
+        }
+        removeNode(node);
+        return true;
+    }
+
+    // Новый бюджет; лишние записи вытесняются сразу
+    void setByteBudget(size_t budget) {
+        byteBudget = budget;
+        evictTo(byteBudget);
+    }
+
+    size_t getByteBudget() const {
+        return byteBudget;
+    }
+
+    size_t getUsedBytes() const {
+        return usedBytes;
+    }
+
+    size_t getSize() const {
+        return table.getSize();
+    }
+
+    uint64_t getHits() const {
+        return hits;
+    }
+
+    uint64_t getMisses() const {
+        return misses;
+    }
+
+    uint64_t getEvictions() const {
+        return evictions;
+    }
+
+    void resetStats() {
+        hits = misses = evictions = 0;
+    }
+};
+
+#endif // LRU_CACHE_H_INCLUDED
@@ -0,0 +1,206 @@
+#ifndef MAPPED_HASH_TABLE_H_INCLUDED
+#define MAPPED_HASH_TABLE_H_INCLUDED
+
+#include "includes.h"
+#include "hash_function.h"
+#include "bloom_filter.h"
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Формат снимка хеш-таблицы, пригодного для отображения в память.
+// Файл состоит из четырёх частей:
+//   SnapshotHeader;
+//   bucketStart[bucketCount + 1] - записи корзины b занимают
+//     диапазон [bucketStart[b], bucketStart[b + 1]) массива записей;
+//   блоки фильтра Блума (если bloomBlocks > 0), выровненные по 64 байтам;
+//   SnapshotEntry[count] - записи, упорядоченные по корзинам;
+//   данные - ключ и сразу за ним значение для каждой записи.
+// Все числа хранятся в порядке байтов машины, записавшей снимок.
+class SnapshotHeader {
+public:
+    static constexpr char MAGIC[8] = {'H', 'T', 'S', 'N', 'A', 'P', '0', '4'};
+
+    char magic[8];
+    uint64_t count;
+    uint64_t bucketCount; // степень двойки
+    uint64_t bucketsOffset;
+    uint64_t entriesOffset;
+    uint64_t dataOffset;
+    uint64_t fileSize;
+    uint64_t hashSeed; // зерно fastHash, которым построен индекс
+    uint64_t bloomOffset;
+    uint64_t bloomBlocks; // 0 - снимок без фильтра
+};
+
+class SnapshotEntry {
+public:
+    uint64_t hash; // полный хеш ключа, сравнивается до сравнения строк
+    uint64_t keyOffset; // смещение ключа от начала файла
+    uint32_t keySize;
+    uint32_t valueSize;
+};
+
+// Снимок, открытый только для чтения прямо из отображения файла:
+// открытие не читает и не разбирает записи, а значения, которые
+// возвращает get, указывают внутрь отображения.
+class MappedHashTable {
+private:
+    const char* base;
+    size_t mappedSize;
+    const SnapshotHeader* header;
+    const uint64_t* bucketStart;
+    const SnapshotEntry* entries;
+    const uint64_t* bloom;
+
+    const SnapshotEntry* find(string_view key) const {
+        if (header == nullptr) {
+            return nullptr;
+        }
+        uint64_t hash = fastHash(key, header->hashSeed);
+        if (bloom != nullptr && !BloomFilter::mayContain(bloom, header->bloomBlocks, hash)) {
+            return nullptr;
+        }
+        uint64_t bucket = hash & (header->bucketCount - 1);
+        // Записи проверяются по мере обращения, а не при открытии,
+        // чтобы открытие не зависело от размера снимка
+        uint64_t end = min(bucketStart[bucket + 1], header->count);
+        for (uint64_t i = bucketStart[bucket]; i < end; ++i) {
+            const SnapshotEntry& entry = entries[i];
+            if (entry.hash == hash && entry.keySize == key.size()
+                && entry.keyOffset + entry.keySize + entry.valueSize <= mappedSize
+                && memcmp(base + entry.keyOffset, key.data(), key.size()) == 0) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    // Проверка, что все части заголовка лежат внутри файла и выровнены.
+    // Количества ограничиваются размером файла до умножения, а смещения -
+    // до сложения, поэтому поля заголовка не переполняют 64-битную арифметику
+    bool validate() const {
+        if (mappedSize < sizeof(SnapshotHeader)
+            || memcmp(header->magic, SnapshotHeader::MAGIC, sizeof(header->magic)) != 0
+            || header->fileSize != mappedSize || header->bucketCount == 0
+            || (header->bucketCount & (header->bucketCount - 1)) != 0
+            || header->bucketCount >= mappedSize / sizeof(uint64_t)
+            || header->count > mappedSize / sizeof(SnapshotEntry)
+            || header->bucketsOffset < sizeof(SnapshotHeader) || header->bucketsOffset > mappedSize
+            || header->bucketsOffset % alignof(uint64_t) != 0
+            || header->entriesOffset > mappedSize || header->entriesOffset % alignof(SnapshotEntry) != 0
+            || header->dataOffset > mappedSize) {
+            return false;
+        }
+        uint64_t bucketsEnd = header->bucketsOffset + (header->bucketCount + 1) * sizeof(uint64_t);
+        uint64_t entriesEnd = header->entriesOffset + header->count * sizeof(SnapshotEntry);
+        if (header->bloomBlocks > 0
+            && (header->bloomBlocks > mappedSize / BloomFilter::blockBytes()
+                || header->bloomOffset < bucketsEnd || header->bloomOffset > mappedSize
+                || header->bloomOffset % BloomFilter::blockBytes() != 0
+                || header->bloomOffset + header->bloomBlocks * BloomFilter::blockBytes() > header->entriesOffset)) {
+            return false;
+        }
+        return bucketsEnd <= header->entriesOffset && entriesEnd <= header->dataOffset;
+    }
+
+public:
+    MappedHashTable()
+        : base(nullptr), mappedSize(0), header(nullptr), bucketStart(nullptr), entries(nullptr),
+          bloom(nullptr) {}
+
+    ~MappedHashTable() {
+        close();
+    }
+
+    MappedHashTable(const MappedHashTable&) = delete;
+    MappedHashTable& operator=(const MappedHashTable&) = delete;
+
+    // Отображение снимка в память; записи не читаются до первого обращения
+    bool open(const string& filename) {
+        close();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            cerr << "Error opening snapshot." << endl;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            cerr << "Error opening snapshot." << endl;
+            return false;
+        }
+        void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            cerr << "Error opening snapshot." << endl;
+            return false;
+        }
+        base = static_cast<const char*>(mapping);
+        mappedSize = info.st_size;
+        header = reinterpret_cast<const SnapshotHeader*>(base);
+        if (!validate()) {
+            close();
+            cerr << "Error: invalid snapshot format." << endl;
+            return false;
+        }
+        bucketStart = reinterpret_cast<const uint64_t*>(base + header->bucketsOffset);
+        entries = reinterpret_cast<const SnapshotEntry*>(base + header->entriesOffset);
+        if (header->bloomBlocks > 0) {
+            bloom = reinterpret_cast<const uint64_t*>(base + header->bloomOffset);
+        }
+        return true;
+    }
+
+    void close() {
+        if (base != nullptr) {
+            munmap(const_cast<char*>(base), mappedSize);
+        }
+        base = nullptr;
+        mappedSize = 0;
+        header = nullptr;
+        bucketStart = nullptr;
+        entries = nullptr;
+        bloom = nullptr;
+    }
+
+    bool isOpen() const {
+        return header != nullptr;
+    }
+
+    bool get(string_view key, string& result) const {
+        const SnapshotEntry* entry = find(key);
+        if (entry == nullptr) {
+            return false; // Ключ не найден
+        }
+        result.assign(base + entry->keyOffset + entry->keySize, entry->valueSize);
+        return true;
+    }
+
+    // Значение указывает прямо в файл и действительно, пока снимок открыт
+    bool get(string_view key, string_view& result) const {
+        const SnapshotEntry* entry = find(key);
+        if (entry == nullptr) {
+            return false; // Ключ не найден
+        }
+        result = string_view(base + entry->keyOffset + entry->keySize, entry->valueSize);
+        return true;
+    }
+
+    size_t getSize() const {
+        return header != nullptr ? header->count : 0;
+    }
+
+    size_t getCapacity() const {
+        return header != nullptr ? header->bucketCount : 0;
+    }
+
+    bool hasBloomFilter() const {
+        return bloom != nullptr;
+    }
+};
+
+#endif // MAPPED_HASH_TABLE_H_INCLUDED
@@ -2,6 +2,7 @@
 #define MASSIVE_H_INCLUDED
 
 #include "includes.h"
+#include "exporter.h"
 
 class StrArray {
 private:
@@ -21,17 +22,68 @@ public:
         delete[] data;
     }
 
-    void resize() {
-        size_t newCapacity = capacity * 2;
+    // Копирование - полная копия элементов
+    StrArray(const StrArray& other) : data(new string[other.capacity]), size(other.size), capacity(other.capacity) {
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = other.data[i];
+        }
+    }
+
+    // Перемещение забирает буфер; исходный массив остаётся пустым и годным
+    StrArray(StrArray&& other) noexcept : data(other.data), size(other.size), capacity(other.capacity) {
+        other.data = nullptr;
+        other.size = 0;
+        other.capacity = 0;
+    }
+
+    // Общее присваивание: копия или перемещение уже сделаны в параметре
+    StrArray& operator=(StrArray other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    void swap(StrArray& other) noexcept {
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        std::swap(capacity, other.capacity);
+    }
+
+    // Перенос в буфер ёмкостью newCapacity >= size; строки переносятся
+    // перемещением, символы не копируются
+    void reallocate(size_t newCapacity) {
         string* newData = new string[newCapacity]; // новый массив
         for (size_t i = 0; i < size; i++) {
-            newData[i] = data[i];
+            newData[i] = move(data[i]);
         }
         delete[] data;
         data = newData; //указатель на новый массив
         capacity = newCapacity;
     }
 
+    // Рост вдвое
+    void resize() {
+        reallocate(capacity > 0 ? capacity * 2 : 1);
+    }
+
+    // Не больше одного перевыделения под extra новых элементов
+    void reserveExtra(size_t extra) {
+        if (size + extra > capacity) {
+            reallocate(max(capacity * 2, size + extra));
+        }
+    }
+
+    void reserve(size_t newCapacity) {
+        if (newCapacity > capacity) {
+            reallocate(newCapacity);
+        }
+    }
+
+    void shrink_to_fit() {
+        if (capacity > size) {
+            reallocate(size);
+        }
+    }
+
     void push(const string& value) {
         if (size >= capacity) {
             resize();
@@ -39,11 +91,29 @@ public:
         data[size++] = value; // заносим строку и увеличиваем размер
     }
 
+    void push(string&& value) {
+        if (size >= capacity) {
+            resize();
+        }
+        data[size++] = move(value);
+    }
+
+    // Добавление строки, построенной из аргументов: временная строка
+    // перемещается в уже созданный слот, символы не копируются повторно.
+    // Настоящее построение на месте требует сырой памяти под слоты
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        if (size >= capacity) {
+            resize();
+        }
+        data[size++] = string(forward<Args>(args)...);
+    }
+
     size_t sizeM() const {
         return size; // Возвращаем текущий размер
     }
 
-    void pushi(size_t index, const string& value) {
+    void pushi(size_t index, string value) {
         if (index < 0 || index > size) {
             cout << "6:ERROR: Index out of range." << endl;
             return;
@@ -53,12 +123,56 @@ public:
         }
         // Сдвигаем элементы вправо
         for (size_t i = size; i > index; --i) {
-            data[i] = data[i - 1];
+            data[i] = move(data[i - 1]);
         }
-        data[index] = value;
+        data[index] = move(value);
         ++size;
     }
 
+    // Вставка count строк с позиции index: один сдвиг хвоста и не больше
+    // одного перевыделения, O(size + count)
+    void pushRange(size_t index, const string* values, size_t count) {
+        if (index > size) {
+            cout << "6:ERROR: Index out of range." << endl;
+            return;
+        }
+        if (values >= data && values < data + capacity) {
+            StrArray copy; // вставка части самого массива
+            copy.reserve(count);
+            copy.pushRange(0, values, count);
+            pushRange(index, copy.data, count);
+            return;
+        }
+        reserveExtra(count);
+        for (size_t i = size; i > index; --i) {
+            data[i + count - 1] = move(data[i - 1]);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            data[index + i] = values[i];
+        }
+        size += count;
+    }
+
+    void append(const string* values, size_t count) {
+        pushRange(size, values, count);
+    }
+
+    // Удаление элементов [first, last) одним сдвигом хвоста
+    void delRange(size_t first, size_t last) {
+        if (first > last || last > size) {
+            cout << "11:ERROR: Index out of range." << endl;
+            return;
+        }
+        size_t count = last - first;
+        for (size_t i = last; i < size; ++i) {
+            data[i - count] = move(data[i]);
+        }
+        for (size_t i = size - count; i < size; ++i) {
+            data[i] = string(); // освобождаем хвостовые слоты
+        }
+        size -= count;
+    }
+
     bool get(size_t index, string& result) {
         if (index < 0 || index >= size) {
             //cout << "10:ERROR: Index out of range." << endl;
@@ -82,20 +196,26 @@ public:
             return;
         }
         for (size_t i = index; i < size - 1; ++i) {
-            data[i] = data[i + 1];
+            data[i] = move(data[i + 1]);
         }
-        --size;
+        data[--size] = string(); // освобождаем последний слот
     }
 
     void saveToFile(const string& filename) const {
-        ofstream file(filename);
+        TextExporter file(filename);
+        if (!file.isOpen()) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
         for (size_t i = 0; i < size; ++i) {
-            file << data[i];
+            file.writeField(data[i]);
             if (i < size - 1) {
-                file << ";";
+                file.write(';');
             }
         }
-        file.close();
+        if (!file.close()) {
+            cerr << "Error writing file." << endl;
+        }
     }
 
     // Метод сериализации
@@ -0,0 +1,217 @@
+#ifndef PACKED_STR_ARRAY_H_INCLUDED
+#define PACKED_STR_ARRAY_H_INCLUDED
+
+#include "includes.h"
+#include "exporter.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Массив строк с тем же интерфейсом, что у StrArray, но с плотным
+// хранением: символы всех элементов лежат подряд в одной арене, а
+// элемент - это пара (смещение, длина) в упакованном массиве. Обход идёт
+// по двум непрерывным буферам без прыжков по куче, а serialize и
+// deserialize - это две крупные записи и два крупных чтения.
+// Замена и удаление оставляют в арене мусор; когда его становится больше
+// половины арены, она уплотняется.
+class PackedStrArray {
+private:
+    class Slot {
+    public:
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    static constexpr size_t MIN_COMPACT = 4096; // мелкий мусор не уплотняется
+
+    string arena;
+    vector<Slot> slots;
+    size_t garbage; // байты арены, не принадлежащие ни одному элементу
+
+    string_view view(size_t index) const {
+        return string_view(arena.data() + slots[index].offset, slots[index].length);
+    }
+
+    Slot append(string_view value) {
+        Slot slot = {arena.size(), value.size()};
+        arena.append(value.data(), value.size());
+        return slot;
+    }
+
+    void compactIfNeeded() {
+        if (garbage >= MIN_COMPACT && garbage * 2 > arena.size()) {
+            compact();
+        }
+    }
+
+    void compact() {
+        string packed;
+        packed.reserve(arena.size() - garbage);
+        for (Slot& slot : slots) {
+            uint64_t offset = packed.size();
+            packed.append(arena, slot.offset, slot.length);
+            slot.offset = offset;
+        }
+        arena.swap(packed);
+        garbage = 0;
+    }
+
+public:
+    PackedStrArray(size_t initialCapacity = 5) : garbage(0) {
+        slots.reserve(initialCapacity);
+    }
+
+    void push(string_view value) {
+        slots.push_back(append(value));
+    }
+
+    size_t sizeM() const {
+        return slots.size();
+    }
+
+    void pushi(size_t index, string_view value) {
+        if (index > slots.size()) {
+            cout << "6:ERROR: Index out of range." << endl;
+            return;
+        }
+        // Сдвигаются только 16-байтные слоты, символы остаются на месте
+        slots.insert(slots.begin() + index, append(value));
+    }
+
+    bool get(size_t index, string& result) const {
+        if (index >= slots.size()) {
+            return false;
+        }
+        result.assign(view(index));
+        return true;
+    }
+
+    // Значение указывает в арену и действительно до следующего изменения
+    bool get(size_t index, string_view& result) const {
+        if (index >= slots.size()) {
+            return false;
+        }
+        result = view(index);
+        return true;
+    }
+
+    void replace(size_t index, string_view value) {
+        if (index >= slots.size()) {
+            cout << "9:ERROR: Index out of range." << endl;
+            return;
+        }
+        Slot& slot = slots[index];
+        if (value.size() <= slot.length) {
+            // Новое значение помещается на место старого
+            memmove(&arena[slot.offset], value.data(), value.size());
+            garbage += slot.length - value.size();
+            slot.length = value.size();
+        } else {
+            garbage += slot.length;
+            slot = append(value);
+        }
+        compactIfNeeded();
+    }
+
+    void del(size_t index) {
+        if (index >= slots.size()) {
+            cout << "11:ERROR: Index out of range." << endl;
+            return;
+        }
+        garbage += slots[index].length;
+        slots.erase(slots.begin() + index);
+        compactIfNeeded();
+    }
+
+    // func(value) для каждого элемента по порядку
+    template <typename Func>
+    void forEach(Func func) const {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            func(view(i));
+        }
+    }
+
+    // Тот же формат, что у StrArray::saveToFile
+    void saveToFile(const string& filename) const {
+        TextExporter file(filename);
+        if (!file.isOpen()) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        for (size_t i = 0; i < slots.size(); ++i) {
+            file.writeField(view(i));
+            if (i + 1 < slots.size()) {
+                file.write(';');
+            }
+        }
+        if (!file.close()) {
+            cerr << "Error writing file." << endl;
+        }
+    }
+
+    // Формат: число элементов, размер арены, слоты, арена. Мусор в файл
+    // не попадает: при его наличии пишется уплотнённая копия
+    void serialize(const string& filename) const {
+        if (garbage > 0) {
+            PackedStrArray packed(*this);
+            packed.compact();
+            packed.serialize(filename);
+            return;
+        }
+        ofstream file(filename, ios::binary);
+        if (!file) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        uint64_t count = slots.size();
+        uint64_t arenaSize = arena.size();
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char*>(&arenaSize), sizeof(arenaSize));
+        file.write(reinterpret_cast<const char*>(slots.data()), count * sizeof(Slot));
+        file.write(arena.data(), arenaSize);
+        file.close();
+    }
+
+    void deserialize(const string& filename) {
+        ifstream file(filename, ios::binary | ios::ate);
+        if (!file) {
+            cerr << "Error opening file for deserialization." << endl;
+            return;
+        }
+        uint64_t fileSize = file.tellg();
+        file.seekg(0);
+        uint64_t count = 0;
+        uint64_t arenaSize = 0;
+        file.read(reinterpret_cast<char*>(&count), sizeof(count));
+        file.read(reinterpret_cast<char*>(&arenaSize), sizeof(arenaSize));
+        uint64_t header = sizeof(count) + sizeof(arenaSize);
+        if (!file || count > fileSize / sizeof(Slot) || header + count * sizeof(Slot) + arenaSize != fileSize) {
+            cerr << "Error: invalid packed array format." << endl;
+            return;
+        }
+        vector<Slot> newSlots(count);
+        string newArena(arenaSize, '\0');
+        file.read(reinterpret_cast<char*>(newSlots.data()), count * sizeof(Slot));
+        file.read(&newArena[0], arenaSize);
+        for (const Slot& slot : newSlots) {
+            if (slot.offset > arenaSize || slot.length > arenaSize - slot.offset) {
+                cerr << "Error: invalid packed array format." << endl;
+                return;
+            }
+        }
+        slots.swap(newSlots);
+        arena.swap(newArena);
+        garbage = 0;
+    }
+
+    size_t getCapacity() const {
+        return slots.capacity();
+    }
+
+    // Байты арены: живые символы и мусор
+    size_t getArenaSize() const {
+        return arena.size();
+    }
+};
+
+#endif // PACKED_STR_ARRAY_H_INCLUDED
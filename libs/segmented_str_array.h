@@ -0,0 +1,192 @@
+#ifndef SEGMENTED_STR_ARRAY_H_INCLUDED
+#define SEGMENTED_STR_ARRAY_H_INCLUDED
+
+#include "includes.h"
+#include "exporter.h"
+#include <memory>
+#include <vector>
+
+// Массив строк из блоков фиксированного размера с тем же интерфейсом,
+// что у StrArray. Каталог хранит указатели на блоки по BLOCK_SIZE строк;
+// рост - это выделение одного нового блока (и изредка рост каталога
+// указателей), элементы при этом не переносятся. Поэтому нет ни
+// задержки на копирование всего массива, ни временного тройного пика
+// памяти, а адрес слота, полученный через at(), остаётся прежним при
+// любых push. Индекс находится сдвигом и маской за O(1).
+// pushi и del сдвигают значения между слотами: адреса слотов не
+// меняются, но значение по адресу меняется.
+class SegmentedStrArray {
+private:
+    static constexpr size_t BLOCK_SHIFT = 8;
+    static constexpr size_t BLOCK_SIZE = size_t(1) << BLOCK_SHIFT;
+
+    vector<unique_ptr<string[]>> blocks;
+    size_t size;
+
+    string& slot(size_t index) {
+        return blocks[index >> BLOCK_SHIFT][index & (BLOCK_SIZE - 1)];
+    }
+
+    const string& slot(size_t index) const {
+        return blocks[index >> BLOCK_SHIFT][index & (BLOCK_SIZE - 1)];
+    }
+
+    // Свободный слот в конце: при необходимости - ровно один новый блок
+    string& grow() {
+        if (size == getCapacity()) {
+            blocks.emplace_back(new string[BLOCK_SIZE]);
+        }
+        return slot(size++);
+    }
+
+public:
+    SegmentedStrArray(size_t initialCapacity = 5) : size(0) {
+        reserve(initialCapacity);
+    }
+
+    SegmentedStrArray(const SegmentedStrArray&) = delete;
+    SegmentedStrArray& operator=(const SegmentedStrArray&) = delete;
+    SegmentedStrArray(SegmentedStrArray&& other) noexcept : blocks(move(other.blocks)), size(other.size) {
+        other.blocks.clear();
+        other.size = 0;
+    }
+
+    SegmentedStrArray& operator=(SegmentedStrArray&& other) noexcept {
+        blocks.swap(other.blocks);
+        swap(size, other.size);
+        return *this;
+    }
+
+    void reserve(size_t newCapacity) {
+        while (getCapacity() < newCapacity) {
+            blocks.emplace_back(new string[BLOCK_SIZE]);
+        }
+    }
+
+    void push(const string& value) {
+        grow() = value;
+    }
+
+    void push(string&& value) {
+        grow() = move(value);
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        grow() = string(forward<Args>(args)...);
+    }
+
+    size_t sizeM() const {
+        return size;
+    }
+
+    void pushi(size_t index, string value) {
+        if (index > size) {
+            cout << "6:ERROR: Index out of range." << endl;
+            return;
+        }
+        grow();
+        for (size_t i = size - 1; i > index; --i) {
+            slot(i) = move(slot(i - 1));
+        }
+        slot(index) = move(value);
+    }
+
+    bool get(size_t index, string& result) const {
+        if (index >= size) {
+            return false;
+        }
+        result = slot(index);
+        return true;
+    }
+
+    // Стабильный адрес слота: действителен, пока массив существует;
+    // nullptr - индекс вне массива
+    string* at(size_t index) {
+        return index < size ? &slot(index) : nullptr;
+    }
+
+    void replace(size_t index, string value) {
+        if (index >= size) {
+            cout << "9:ERROR: Index out of range." << endl;
+            return;
+        }
+        slot(index) = move(value);
+    }
+
+    void del(size_t index) {
+        if (index >= size) {
+            cout << "11:ERROR: Index out of range." << endl;
+            return;
+        }
+        for (size_t i = index; i + 1 < size; ++i) {
+            slot(i) = move(slot(i + 1));
+        }
+        slot(--size) = string(); // освобождаем последний слот
+    }
+
+    // Тот же формат, что у StrArray::saveToFile
+    void saveToFile(const string& filename) const {
+        TextExporter file(filename);
+        if (!file.isOpen()) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            file.writeField(slot(i));
+            if (i + 1 < size) {
+                file.write(';');
+            }
+        }
+        if (!file.close()) {
+            cerr << "Error writing file." << endl;
+        }
+    }
+
+    // Тот же формат, что у StrArray::serialize
+    void serialize(const string& filename) const {
+        ofstream file(filename, ios::binary);
+        if (!file) {
+            cerr << "Error opening file for serialization." << endl;
+            return;
+        }
+        size_t capacity = getCapacity();
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(&capacity), sizeof(capacity));
+        for (size_t i = 0; i < size; ++i) {
+            size_t len = slot(i).size();
+            file.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            file.write(slot(i).data(), len);
+        }
+        file.close();
+    }
+
+    void deserialize(const string& filename) {
+        ifstream file(filename, ios::binary);
+        if (!file) {
+            cerr << "Error opening file for deserialization." << endl;
+            return;
+        }
+        size_t newSize = 0;
+        size_t capacity = 0;
+        file.read(reinterpret_cast<char*>(&newSize), sizeof(newSize));
+        file.read(reinterpret_cast<char*>(&capacity), sizeof(capacity));
+        blocks.clear();
+        size = 0;
+        reserve(newSize);
+        for (size_t i = 0; i < newSize; ++i) {
+            size_t len;
+            file.read(reinterpret_cast<char*>(&len), sizeof(len));
+            string& value = grow();
+            value.resize(len);
+            file.read(&value[0], len);
+        }
+        file.close();
+    }
+
+    size_t getCapacity() const {
+        return blocks.size() * BLOCK_SIZE;
+    }
+};
+
+#endif // SEGMENTED_STR_ARRAY_H_INCLUDED
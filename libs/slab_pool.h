@@ -0,0 +1,109 @@
+#ifndef SLAB_POOL_H_INCLUDED
+#define SLAB_POOL_H_INCLUDED
+
+#include "includes.h"
+#include <cstddef>
+#include <new>
+
+// Пул блоков одного размера: память берётся у системы крупными плитами
+// (slab), освобождённые блоки возвращаются в список свободных и выдаются
+// повторно, а деструктор отдаёт все плиты разом, не обходя блоки по одному.
+class SlabPool {
+private:
+    class Slab {
+    public:
+        Slab* next;
+    };
+
+    size_t align; // выравнивание плит и блоков, степень двойки
+    size_t blockSize;
+    size_t blocksPerSlab;
+    Slab* slabs;
+    void* freeList; // свободные блоки связаны через своё первое слово
+    char* cursor; // ещё не выданная часть последней плиты
+    char* cursorEnd;
+    size_t slabCount;
+
+    size_t roundUp(size_t size) const {
+        return (size + align - 1) / align * align;
+    }
+
+    // Заголовок плиты занимает место, кратное выравниванию блоков
+    size_t header() const {
+        return roundUp(sizeof(Slab));
+    }
+
+public:
+    // alignment - выравнивание блоков; например, размер кэш-линии, чтобы
+    // блок такого размера не пересекал границу линий
+    SlabPool(size_t size, size_t perSlab = 1024, size_t alignment = alignof(max_align_t))
+        : align(alignment), blockSize(roundUp(max(size, sizeof(void*)))),
+          blocksPerSlab(perSlab > 0 ? perSlab : 1), slabs(nullptr), freeList(nullptr),
+          cursor(nullptr), cursorEnd(nullptr), slabCount(0) {}
+
+    ~SlabPool() {
+        clear();
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    void* allocate() {
+        if (freeList != nullptr) {
+            void* block = freeList;
+            freeList = *static_cast<void**>(block);
+            return block;
+        }
+        if (cursor == cursorEnd) {
+            Slab* slab = static_cast<Slab*>(::operator new(header() + blockSize * blocksPerSlab, align_val_t(align)));
+            slab->next = slabs;
+            slabs = slab;
+            cursor = reinterpret_cast<char*>(slab) + header();
+            cursorEnd = cursor + blockSize * blocksPerSlab;
+            ++slabCount;
+        }
+        void* block = cursor;
+        cursor += blockSize;
+        return block;
+    }
+
+    void release(void* block) {
+        *static_cast<void**>(block) = freeList;
+        freeList = block;
+    }
+
+    // Освобождение всех плит; выданные блоки становятся недействительными
+    void clear() {
+        while (slabs != nullptr) {
+            Slab* next = slabs->next;
+            ::operator delete(slabs, align_val_t(align));
+            slabs = next;
+        }
+        freeList = nullptr;
+        cursor = cursorEnd = nullptr;
+        slabCount = 0;
+    }
+
+    size_t getSlabCount() const {
+        return slabCount;
+    }
+
+    // Смена размера блока (и выравнивания, если alignment != 0); возможна,
+    // только пока пул не выдал ни одной плиты
+    bool setBlockSize(size_t size, size_t alignment = 0) {
+        if (slabs != nullptr) {
+            return false;
+        }
+        if (alignment != 0) {
+            align = alignment;
+        }
+        blockSize = roundUp(max(size, sizeof(void*)));
+        return true;
+    }
+
+    size_t getBlockSize() const {
+        return blockSize;
+    }
+};
+
+#endif // SLAB_POOL_H_INCLUDED
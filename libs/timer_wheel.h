@@ -0,0 +1,137 @@
+#ifndef TIMER_WHEEL_H_INCLUDED
+#define TIMER_WHEEL_H_INCLUDED
+
+#include "includes.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Источник времени в миллисекундах; подменяется в тестах
+using TimeSource = uint64_t (*)();
+
+inline uint64_t steadyMilliseconds() {
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::milliseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Иерархическое колесо таймеров: LEVELS уровней по 64 ячейки, ячейка
+// уровня k покрывает 64^k тиков. Таймер кладётся на самый нижний
+// уровень, до которого дотягивается его срок, и спускается на уровень
+// ниже, когда время доходит до его ячейки. Вставка O(1), а каждый
+// таймер за свою жизнь переносится не больше LEVELS раз. Пустые ячейки
+// нижнего уровня пропускаются по битовой маске занятости.
+// Таймер - пара (id, срок); отменять таймеры не нужно: владелец
+// проверяет при срабатывании, актуален ли ещё срок.
+class TimerWheel {
+public:
+    class Timer {
+    public:
+        uint64_t id;
+        uint64_t expireAt;
+    };
+
+private:
+    static constexpr int LEVELS = 4; // 64^4 тиков - около 4,6 часа при тике 1 мс
+    static constexpr uint64_t SLOTS = 64;
+
+    vector<Timer> slots[LEVELS][SLOTS];
+    uint64_t occupied[LEVELS]; // бит s - ячейка s не пуста
+    uint64_t current; // время, до которого колесо уже обработано
+    size_t count;
+
+    void place(const Timer& timer) {
+        uint64_t delta = timer.expireAt > current ? timer.expireAt - current : 0;
+        int level = 0;
+        uint64_t span = SLOTS;
+        while (level < LEVELS - 1 && delta >= span) {
+            ++level;
+            span *= SLOTS;
+        }
+        // Дальше верхнего уровня - в его самую дальнюю ячейку, оттуда
+        // таймер будет переложен заново
+        uint64_t at = level == LEVELS - 1 && delta >= span ? current + span - 1 : max(timer.expireAt, current);
+        uint64_t slot = (at >> (6 * level)) & (SLOTS - 1);
+        slots[level][slot].push_back(timer);
+        occupied[level] |= 1ULL << slot;
+    }
+
+    // Перенос ячейки уровня level, до которой дошло время, на уровни ниже
+    void cascade(int level) {
+        uint64_t slot = (current >> (6 * level)) & (SLOTS - 1);
+        if (!(occupied[level] & (1ULL << slot))) {
+            return;
+        }
+        vector<Timer> moved;
+        moved.swap(slots[level][slot]);
+        occupied[level] &= ~(1ULL << slot);
+        for (const Timer& timer : moved) {
+            place(timer);
+        }
+    }
+
+public:
+    TimerWheel(uint64_t now = 0) : current(now), count(0) {
+        for (int level = 0; level < LEVELS; ++level) {
+            occupied[level] = 0;
+        }
+    }
+
+    void schedule(uint64_t id, uint64_t expireAt) {
+        place(Timer{id, expireAt});
+        ++count;
+    }
+
+    // Обработка времени до now включительно: onExpire(timer) для каждого
+    // таймера со сроком <= now
+    template <typename Func>
+    void advance(uint64_t now, Func onExpire) {
+        if (count == 0) {
+            current = max(current, now);
+            return;
+        }
+        while (true) {
+            uint64_t slot = current & (SLOTS - 1);
+            if (occupied[0] & (1ULL << slot)) {
+                vector<Timer> due;
+                due.swap(slots[0][slot]);
+                occupied[0] &= ~(1ULL << slot);
+                count -= due.size();
+                for (const Timer& timer : due) {
+                    onExpire(timer);
+                }
+            }
+            if (current >= now) {
+                break;
+            }
+            // Следующая занятая ячейка нижнего уровня или граница его оборота
+            uint64_t ahead = slot == SLOTS - 1 ? 0 : occupied[0] & (~0ULL << (slot + 1));
+            uint64_t boundary = (current | (SLOTS - 1)) + 1;
+            uint64_t next = ahead != 0 ? (current & ~(SLOTS - 1)) + __builtin_ctzll(ahead) : boundary;
+            current = min(next, now);
+            if (current == boundary) {
+                // Верхние уровни переносятся раньше нижних
+                int top = 1;
+                while (top < LEVELS - 1 && (current & ((1ULL << (6 * (top + 1))) - 1)) == 0) {
+                    ++top;
+                }
+                for (int level = top; level >= 1; --level) {
+                    cascade(level);
+                }
+            }
+            if (count == 0) {
+                current = now;
+                break;
+            }
+        }
+    }
+
+    size_t getSize() const {
+        return count;
+    }
+
+    uint64_t getTime() const {
+        return current;
+    }
+};
+
+#endif // TIMER_WHEEL_H_INCLUDED
@@ -1,8 +1,21 @@
 #include "gtest/gtest.h"
 #include "../libs/hash_table.h"
+#include "../libs/flat_hash_table.h"
+#include "../libs/concurrent_hash_table.h"
+#include "../libs/lock_free_read_hash_table.h"
+#include "../libs/lru_cache.h"
+#include "../libs/durable_hash_table.h"
+#include "../libs/frozen_hash_table.h"
+#include <atomic>
+#include <memory>
+#include <set>
+#include <thread>
 #include "../libs/listD.h"
 #include "../libs/listS.h"
 #include "../libs/massive.h"
+#include "../libs/packed_str_array.h"
+#include "../libs/gap_str_array.h"
+#include "../libs/segmented_str_array.h"
 #include "../libs/queue.h"
 #include "../libs/stack.h"
 #include "../libs/tree.h"
@@ -128,6 +141,122 @@ TEST(StrArrayTest, SaveToFile) {
     remove("test.txt"); // Удаление тестового файла
 }
 
+// Тест экранирования ';' в элементах при сохранении
+TEST(StrArrayTest, SaveToFileEscapes) {
+    StrArray array;
+    array.push("a;b");
+    array.push("c\\d");
+    array.push("e");
+    array.saveToFile("test.txt");
+    ifstream file("test.txt");
+    stringstream buffer;
+    buffer << file.rdbuf();
+    EXPECT_EQ(buffer.str(), "a\\;b;c\\\\d;e");
+    file.close();
+    remove("test.txt");
+}
+
+// Тест копирования и перемещения массива
+TEST(StrArrayTest, CopyAndMove) {
+    StrArray array(1);
+    array.push("one");
+    array.push("two");
+    StrArray copy(array);
+    copy.replace(0, "changed");
+    string result;
+    EXPECT_TRUE(array.get(0, result)); // Копия не делит память с оригиналом
+    EXPECT_EQ(result, "one");
+    StrArray moved(move(copy));
+    EXPECT_EQ(moved.sizeM(), 2);
+    EXPECT_EQ(copy.sizeM(), 0);
+    copy.push("again"); // Перемещённый массив остаётся годным
+    EXPECT_EQ(copy.sizeM(), 1);
+    array = moved;
+    EXPECT_TRUE(array.get(0, result));
+    EXPECT_EQ(result, "changed");
+    array = StrArray();
+    EXPECT_EQ(array.sizeM(), 0);
+}
+
+// Тест роста перемещением: буферы длинных строк не копируются
+TEST(StrArrayTest, MoveGrowthAndEmplace) {
+    StrArray array(1);
+    string big(1000, 'x');
+    array.push(move(big));
+    EXPECT_TRUE(big.empty()); // Строка забрана, а не скопирована
+    for (int i = 0; i < 100; ++i) {
+        array.emplace(10, 'y');
+    }
+    array.pushi(0, string(500, 'z'));
+    array.del(0);
+    EXPECT_EQ(array.sizeM(), 101);
+    string result;
+    EXPECT_TRUE(array.get(1, result));
+    EXPECT_EQ(result, "yyyyyyyyyy");
+    array.emplace();
+    EXPECT_TRUE(array.get(101, result));
+    EXPECT_EQ(result, "");
+    StrArray other(move(array));
+    // Первый элемент пережил семь ростов и перемещение массива
+    EXPECT_TRUE(other.get(0, result));
+    EXPECT_EQ(result, string(1000, 'x'));
+}
+
+// Тест пакетной вставки и удаления диапазона
+TEST(StrArrayTest, RangeOperations) {
+    StrArray array(2);
+    string head[] = {"a", "b", "c"};
+    array.append(head, 3);
+    string middle[] = {"x", "y"};
+    array.pushRange(1, middle, 2); // a x y b c
+    EXPECT_EQ(array.sizeM(), 5);
+    EXPECT_EQ(array.getCapacity(), 8); // По одному удвоению на пакет: 2 -> 4 -> 8
+    array.delRange(0, 2); // y b c
+    string result;
+    EXPECT_TRUE(array.get(0, result));
+    EXPECT_EQ(result, "y");
+    EXPECT_TRUE(array.get(2, result));
+    EXPECT_EQ(result, "c");
+    EXPECT_EQ(array.sizeM(), 3);
+    testing::internal::CaptureStdout();
+    array.delRange(2, 4);
+    array.pushRange(4, middle, 2);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "11:ERROR: Index out of range.\n6:ERROR: Index out of range.\n");
+    array.append(nullptr, 0);
+    EXPECT_EQ(array.sizeM(), 3);
+}
+
+// Тест резервирования и возврата лишней ёмкости
+TEST(StrArrayTest, ReserveAndShrink) {
+    StrArray array;
+    array.reserve(100);
+    EXPECT_EQ(array.getCapacity(), 100);
+    for (int i = 0; i < 100; ++i) {
+        array.push("item" + to_string(i));
+    }
+    EXPECT_EQ(array.getCapacity(), 100); // Без перевыделений
+    array.delRange(10, 100);
+    array.shrink_to_fit();
+    EXPECT_EQ(array.getCapacity(), 10);
+    string result;
+    EXPECT_TRUE(array.get(9, result));
+    EXPECT_EQ(result, "item9");
+    array.reserve(5); // Меньше текущей ёмкости - ничего не меняется
+    EXPECT_EQ(array.getCapacity(), 10);
+}
+
+// Тест сохранения в недоступный файл: ошибка не теряется
+TEST(StrArrayTest, SaveToFileReportsOpenError) {
+    StrArray array;
+    array.push("one");
+    testing::internal::CaptureStderr();
+    array.saveToFile("no_such_dir/test.txt");
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "Error opening file for serialization.\n");
+    TextExporter file("no_such_dir/test.txt");
+    file.writeField("value");
+    EXPECT_FALSE(file.close());
+}
+
 // Тест сериализации и десериализации массива
 TEST(StrArrayTest, SerializeDeserialize) {
     StrArray array;
@@ -153,6 +282,176 @@ TEST(StrArrayTest, SerializeDeserialize) {
     }
 }
 
+// Тесты для плотного массива строк -----------------------------------------------------------------------------------------
+
+// Тест плотного массива строк: тот же интерфейс, что у StrArray
+TEST(PackedStrArrayTest, PushInsertReplaceDelete) {
+    PackedStrArray array;
+    array.push("one");
+    array.push("three");
+    array.pushi(1, "two");
+    testing::internal::CaptureStdout();
+    array.pushi(5, "bad");
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "6:ERROR: Index out of range.\n");
+    array.replace(2, "3"); // Короче старого - на месте
+    array.replace(0, "first element"); // Длиннее - в конец арены
+    string result;
+    EXPECT_TRUE(array.get(0, result));
+    EXPECT_EQ(result, "first element");
+    string_view view;
+    EXPECT_TRUE(array.get(2, view));
+    EXPECT_EQ(view, "3");
+    array.del(1);
+    EXPECT_EQ(array.sizeM(), 2);
+    EXPECT_FALSE(array.get(2, result));
+    // Мусор от замен уплотняется
+    for (int i = 0; i < 1000; ++i) {
+        array.replace(1, string(100 + i % 2, 'x'));
+    }
+    EXPECT_LT(array.getArenaSize(), 20000);
+    EXPECT_TRUE(array.get(1, result));
+    EXPECT_EQ(result, string(101, 'x'));
+}
+
+// Тест сериализации плотного массива двумя блоками
+TEST(PackedStrArrayTest, SerializeDeserialize) {
+    PackedStrArray array;
+    for (int i = 0; i < 100; ++i) {
+        array.push("item" + to_string(i));
+    }
+    array.del(0);
+    array.push("");
+    array.serialize("packed_test.bin");
+    PackedStrArray loaded;
+    loaded.deserialize("packed_test.bin");
+    EXPECT_EQ(loaded.sizeM(), 100);
+    EXPECT_EQ(loaded.getArenaSize(), array.getArenaSize() - 5); // "item0" не сохранён
+    size_t index = 0;
+    loaded.forEach([&](string_view value) {
+        string expected;
+        array.get(index++, expected);
+        EXPECT_EQ(value, expected);
+    });
+    ofstream("packed_test.bin", ios::binary | ios::app) << "junk";
+    testing::internal::CaptureStderr();
+    loaded.deserialize("packed_test.bin");
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "Error: invalid packed array format.\n");
+    EXPECT_EQ(loaded.sizeM(), 100);
+    remove("packed_test.bin");
+}
+
+// Тесты для массива с разрывом ---------------------------------------------------------------------------------------------
+
+// Тест массива с разрывом: правки вокруг движущейся позиции
+TEST(GapStrArrayTest, ClusteredEdits) {
+    GapStrArray array(2);
+    StrArray reference(2);
+    size_t position = 0;
+    for (int i = 0; i < 500; ++i) {
+        string value = "v" + to_string(i);
+        if (i % 7 == 3 && array.sizeM() > 0) {
+            size_t index = position % array.sizeM();
+            array.del(index);
+            reference.del(index);
+        } else {
+            array.pushi(position, value);
+            reference.pushi(position, value);
+        }
+        position = (position + (i % 5 == 0 ? 37 : 1)) % (array.sizeM() + 1);
+    }
+    ASSERT_EQ(array.sizeM(), reference.sizeM());
+    for (size_t i = 0; i < array.sizeM(); ++i) {
+        string expected;
+        string result;
+        reference.get(i, expected);
+        EXPECT_TRUE(array.get(i, result));
+        EXPECT_EQ(result, expected);
+    }
+    array.replace(0, "first");
+    string result;
+    EXPECT_TRUE(array.get(0, result));
+    EXPECT_EQ(result, "first");
+    testing::internal::CaptureStdout();
+    array.pushi(array.sizeM() + 1, "bad");
+    array.del(array.sizeM());
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "6:ERROR: Index out of range.\n11:ERROR: Index out of range.\n");
+}
+
+// Тест совместимости файлов с StrArray
+TEST(GapStrArrayTest, SerializeCompatibleWithStrArray) {
+    GapStrArray array;
+    array.push("two");
+    array.push("three");
+    array.pushi(0, "one");
+    array.serialize("gap_test.bin");
+    StrArray loaded;
+    loaded.deserialize("gap_test.bin");
+    EXPECT_EQ(loaded.sizeM(), 3);
+    string result;
+    EXPECT_TRUE(loaded.get(0, result));
+    EXPECT_EQ(result, "one");
+    loaded.serialize("gap_test.bin");
+    GapStrArray again;
+    again.deserialize("gap_test.bin");
+    again.pushi(1, "between");
+    EXPECT_TRUE(again.get(2, result));
+    EXPECT_EQ(result, "two");
+    remove("gap_test.bin");
+}
+
+// Тесты для блочного массива -----------------------------------------------------------------------------------------------
+
+// Тест блочного массива: рост не переносит элементы
+TEST(SegmentedStrArrayTest, StableAddresses) {
+    SegmentedStrArray array(1);
+    array.push("first");
+    string* first = array.at(0);
+    const char* characters = first->data();
+    for (int i = 1; i < 10000; ++i) {
+        array.emplace("item" + to_string(i));
+    }
+    EXPECT_EQ(array.at(0), first); // Адрес слота и буфер строки не изменились
+    EXPECT_EQ(first->data(), characters);
+    EXPECT_EQ(array.at(10000), nullptr);
+    EXPECT_EQ(array.getCapacity() % 256, 0);
+    EXPECT_LT(array.getCapacity() - array.sizeM(), 256); // Рост по одному блоку
+    array.pushi(1, "second");
+    array.del(0);
+    string result;
+    EXPECT_TRUE(array.get(0, result));
+    EXPECT_EQ(result, "second");
+    EXPECT_TRUE(array.get(9999, result));
+    EXPECT_EQ(result, "item9999");
+    array.replace(9999, "last");
+    EXPECT_EQ(*array.at(9999), "last");
+    testing::internal::CaptureStdout();
+    array.replace(10000, "bad");
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "9:ERROR: Index out of range.\n");
+}
+
+// Тест совместимости файлов с StrArray
+TEST(SegmentedStrArrayTest, SerializeCompatibleWithStrArray) {
+    SegmentedStrArray array;
+    for (int i = 0; i < 600; ++i) {
+        array.push("value" + to_string(i));
+    }
+    array.serialize("segmented_test.bin");
+    StrArray loaded;
+    loaded.deserialize("segmented_test.bin");
+    EXPECT_EQ(loaded.sizeM(), 600);
+    loaded.serialize("segmented_test.bin");
+    SegmentedStrArray again;
+    again.deserialize("segmented_test.bin");
+    EXPECT_EQ(again.sizeM(), 600);
+    string result;
+    EXPECT_TRUE(again.get(599, result));
+    EXPECT_EQ(result, "value599");
+    SegmentedStrArray moved(move(again));
+    EXPECT_EQ(moved.sizeM(), 600);
+    EXPECT_EQ(again.sizeM(), 0);
+    remove("segmented_test.bin");
+}
+
 // Тесты для хеш-таблицы --------------------------------------------------------------------------------------------------
 
 // Тест создания хеш-таблицы
@@ -292,6 +591,1319 @@ TEST(HashTableTest, LoadFromBinaryFile) {
     fs::remove(filename); // Удаление тестового файла
 }
 
+// Тест автоматического роста таблицы при превышении порога заполненности
+TEST(HashTableTest, GrowsOnLoadFactor) {
+    HashTable table(4);
+    for (int i = 0; i < 100; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    EXPECT_EQ(table.getSize(), 100);
+    EXPECT_GE(table.getCapacity(), 100); // Ёмкость выросла вслед за количеством ключей
+    EXPECT_LE(table.getLoadFactor(), 1.0);
+    for (int i = 0; i < 100; ++i) {
+        string result;
+        EXPECT_TRUE(table.get("key" + to_string(i), result)); // Цепочки перераспределены без потерь
+        EXPECT_EQ(result, "value" + to_string(i));
+    }
+}
+
+// Тест сжатия таблицы при падении заполненности ниже порога
+TEST(HashTableTest, ShrinksOnLoadFactor) {
+    HashTable table(4, 1.0, 0.25);
+    for (int i = 0; i < 256; ++i) {
+        table.push("key" + to_string(i), "value");
+    }
+    size_t grown = table.getCapacity();
+    for (int i = 0; i < 250; ++i) {
+        EXPECT_TRUE(table.del("key" + to_string(i)));
+    }
+    EXPECT_LT(table.getCapacity(), grown); // Таблица сжалась
+    EXPECT_GE(table.getCapacity(), 4); // Но не меньше начальной ёмкости
+    string result;
+    EXPECT_TRUE(table.get("key255", result));
+    EXPECT_EQ(table.getSize(), 6);
+}
+
+// Тест: пороги, при которых таблица росла бы на каждой вставке или
+// меняла размер туда-обратно, отклоняются
+TEST(HashTableTest, RejectsInvalidLoadFactors) {
+    testing::internal::CaptureStderr();
+    HashTable table(10, 0.0); // Заменяется на 1.0
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "Error: invalid load factors.\n");
+    for (int i = 0; i < 100; ++i) {
+        table.push("key" + to_string(i), "value");
+    }
+    EXPECT_LE(table.getCapacity(), 160);
+
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(table.setLoadFactors(1.0, 0.6)); // min выше max / 2
+    EXPECT_FALSE(table.setLoadFactors(-1.0));
+    EXPECT_FALSE(table.setLoadFactors(1.0, -0.1));
+    EXPECT_FALSE(table.setLoadFactors(numeric_limits<double>::quiet_NaN()));
+    testing::internal::GetCapturedStderr();
+    size_t capacity = table.getCapacity();
+    for (int i = 0; i < 100; ++i) {
+        table.del("key0");
+        table.push("key0", "value");
+    }
+    EXPECT_EQ(table.getCapacity(), capacity); // Прежние пороги не изменились
+    EXPECT_TRUE(table.setLoadFactors(2.0, 0.5));
+    EXPECT_LE(table.getLoadFactor(), 2.0);
+}
+
+// Тест постепенного рехеша: во время миграции доступны ключи из обоих массивов
+TEST(HashTableTest, IncrementalRehash) {
+    HashTable table(8);
+    table.setIncrementalRehash(true, 1);
+    bool sawRehashing = false;
+    for (int i = 0; i < 500; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+        sawRehashing = sawRehashing || table.isRehashing();
+        string result;
+        EXPECT_TRUE(table.get("key0", result)); // Старые ключи видны на любом шаге миграции
+    }
+    EXPECT_TRUE(sawRehashing);
+    EXPECT_TRUE(table.del("key1"));
+    EXPECT_FALSE(table.del("key1"));
+    testing::internal::CaptureStdout();
+    table.push("key2", "other"); // Дубликат обнаруживается и в старом массиве
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "6:ERROR: Key already exists.\n");
+    for (int i = 2; i < 500; ++i) {
+        string result;
+        EXPECT_TRUE(table.get("key" + to_string(i), result));
+        EXPECT_EQ(result, "value" + to_string(i));
+    }
+    table.setIncrementalRehash(false); // Выключение завершает миграцию
+    EXPECT_FALSE(table.isRehashing());
+    EXPECT_EQ(table.getSize(), 499);
+}
+
+// Тест поиска по срезу буфера и получения значения без копирования
+TEST(HashTableTest, StringViewLookup) {
+    HashTable table;
+    const char buffer[] = "user:42;payload";
+    string_view line(buffer);
+    table.push(line.substr(0, 7), line.substr(8)); // Ключ и значение - срезы одного буфера
+    string_view value;
+    EXPECT_TRUE(table.get(string_view(buffer, 7), value));
+    EXPECT_EQ(value, "payload");
+    const char* raw = "user:42";
+    string copy;
+    EXPECT_TRUE(table.get(raw, copy));
+    EXPECT_EQ(copy, "payload");
+    EXPECT_FALSE(table.get(string_view(buffer, 6), value)); // "user:4" - другой ключ
+    EXPECT_TRUE(table.del(string_view(buffer, 7)));
+    EXPECT_FALSE(table.get(raw, value));
+}
+
+// Тест коротких и длинных пар: внутри узла и во внешнем буфере
+TEST(HashTableTest, InlineAndExternalPairs) {
+    HashTable table;
+    string longKey(100, 'k');
+    string longValue(1000, 'v');
+    table.push("short", "value");
+    table.push(longKey, longValue);
+    table.push("", ""); // Пустые ключ и значение тоже допустимы
+    table.push("k", longValue);
+    string result;
+    EXPECT_TRUE(table.get("short", result));
+    EXPECT_EQ(result, "value");
+    EXPECT_TRUE(table.get(longKey, result));
+    EXPECT_EQ(result, longValue);
+    EXPECT_TRUE(table.get("", result));
+    EXPECT_EQ(result, "");
+    EXPECT_TRUE(table.get("k", result));
+    EXPECT_EQ(result, longValue);
+    EXPECT_TRUE(table.del(longKey));
+    EXPECT_FALSE(table.get(longKey, result));
+}
+
+// Тест выравнивания пула: блоки размером в кэш-линию не пересекают линий
+TEST(HashTableTest, SlabPoolAlignment) {
+    SlabPool pool(64, 3, 64);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(pool.allocate()) % 64, 0);
+    }
+    EXPECT_EQ(pool.getSlabCount(), 4);
+    EXPECT_FALSE(pool.setBlockSize(80)); // Плиты уже выданы
+    pool.clear();
+    EXPECT_TRUE(pool.setBlockSize(80, 16));
+    EXPECT_EQ(pool.getBlockSize(), 80);
+}
+
+// Тест повторного использования узлов пула после удаления
+TEST(HashTableTest, NodePoolRecyclesNodes) {
+    HashTable table;
+    for (int i = 0; i < 1000; ++i) {
+        table.push("key" + to_string(i), "value");
+    }
+    size_t slabs = table.getSlabCount();
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_TRUE(table.del("key" + to_string(i)));
+        }
+        for (int i = 0; i < 1000; ++i) {
+            table.push("key" + to_string(i), "value");
+        }
+    }
+    EXPECT_EQ(table.getSlabCount(), slabs); // Освобождённые узлы выдаются повторно
+    EXPECT_EQ(table.getSize(), 1000);
+}
+
+// Тест пакетной вставки с проверкой дубликатов и без неё
+TEST(HashTableTest, PushBatch) {
+    HashTable table;
+    vector<pair<string, string>> batch;
+    for (int i = 0; i < 1000; ++i) {
+        batch.emplace_back("key" + to_string(i), "value" + to_string(i));
+    }
+    table.pushBatch(batch, true);
+    EXPECT_EQ(table.getSize(), 1000);
+    EXPECT_GE(table.getCapacity(), 1000); // Таблица расширена под пакет заранее
+
+    vector<pair<string_view, string_view>> more = {{"key5", "dup"}, {"new", "value"}, {"new", "again"}};
+    testing::internal::CaptureStdout();
+    table.pushBatch(more);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              "6:ERROR: Key already exists.\n6:ERROR: Key already exists.\n");
+    string result;
+    EXPECT_TRUE(table.get("key5", result));
+    EXPECT_EQ(result, "value5");
+    EXPECT_TRUE(table.get("new", result));
+    EXPECT_EQ(result, "value");
+    EXPECT_EQ(table.getSize(), 1001);
+}
+
+// Тест: пакет, вставленный при живом снимке, не оставляет таблицу
+// переполненной после освобождения снимка
+TEST(HashTableTest, BatchGrowsAfterSnapshot) {
+    HashTable table(4);
+    unique_ptr<HashTable::Snapshot> snapshot = table.snapshot();
+    vector<pair<string, string>> batch;
+    for (int i = 0; i < 1000; ++i) {
+        batch.emplace_back("key" + to_string(i), "value");
+    }
+    table.pushBatch(batch, true);
+    EXPECT_EQ(table.getCapacity(), 4); // Пока снимок жив, массив корзин не меняется
+    EXPECT_EQ(snapshot->getSize(), 0);
+    snapshot.reset();
+    table.push("more", "value");
+    EXPECT_LE(table.getLoadFactor(), 1.0); // Рост сразу догоняет количество
+    string result;
+    EXPECT_TRUE(table.get("key999", result));
+}
+
+// Тест загрузки доверенного файла одним пакетом
+TEST(HashTableTest, TrustedBulkLoad) {
+    HashTable table;
+    for (int i = 0; i < 500; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    table.saveToBinaryFile("bulk_test.bin");
+    table.saveToFile("bulk_test.txt");
+
+    HashTable fromBinary;
+    fromBinary.loadFromBinaryFile("bulk_test.bin", true);
+    HashTable fromText;
+    fromText.loadFromFile("bulk_test.txt", true);
+    EXPECT_EQ(fromBinary.getSize(), 500);
+    EXPECT_EQ(fromText.getSize(), 500);
+    string result;
+    EXPECT_TRUE(fromBinary.get("key499", result));
+    EXPECT_EQ(result, "value499");
+    EXPECT_TRUE(fromText.get("key0", result));
+    EXPECT_EQ(result, "value0");
+
+    HashTable reserved;
+    reserved.reserve(1000);
+    EXPECT_GE(reserved.getCapacity(), 1000);
+    fs::remove("bulk_test.bin");
+    fs::remove("bulk_test.txt");
+}
+
+// Тест разбора строк key;value
+TEST(HashTableTest, LineScanner) {
+    string text = "a;1\nno separator line\n;empty key\nlong key over sixteen bytes;v;with;separators\nlast;x";
+    LineScanner scanner(text.data(), text.data() + text.size());
+    string_view key, value;
+    vector<pair<string, string>> lines;
+    while (scanner.next(key, value)) {
+        lines.emplace_back(key, value);
+    }
+    ASSERT_EQ(lines.size(), 4);
+    EXPECT_EQ(lines[0], make_pair(string("a"), string("1")));
+    EXPECT_EQ(lines[1], make_pair(string(""), string("empty key")));
+    EXPECT_EQ(lines[2], make_pair(string("long key over sixteen bytes"), string("v;with;separators")));
+    EXPECT_EQ(lines[3], make_pair(string("last"), string("x"))); // Без перевода строки в конце
+
+    // Значение начинается через байт после ключа и у экранированной строки
+    string escaped = "k\\;ey;va\\nl\n";
+    LineScanner unescaper(escaped.data(), escaped.data() + escaped.size());
+    ASSERT_TRUE(unescaper.next(key, value));
+    EXPECT_EQ(key, "k;ey");
+    EXPECT_EQ(value, "va\nl");
+    EXPECT_EQ(value.data(), key.data() + key.size() + 1);
+}
+
+// Тест параллельной загрузки: результат совпадает с загрузкой одним потоком
+TEST(HashTableTest, ParallelLoadFromFile) {
+    {
+        ofstream file("parallel_test.txt");
+        for (int i = 0; i < 80000; ++i) {
+            file << "key" << i << ";value" << i << (i % 7 == 0 ? ";x" : "") << "\n";
+        }
+        file << "key5;duplicate\n" << "no separator\n";
+    }
+    HashTable serial;
+    HashTable parallel;
+    serial.push("key1", "existing");
+    parallel.push("key1", "existing");
+    testing::internal::CaptureStdout();
+    serial.loadFromFile("parallel_test.txt", false, 1);
+    string serialOutput = testing::internal::GetCapturedStdout();
+    testing::internal::CaptureStdout();
+    parallel.loadFromFile("parallel_test.txt", false, 4);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), serialOutput);
+    EXPECT_EQ(serialOutput, "6:ERROR: Key already exists.\n6:ERROR: Key already exists.\n");
+    EXPECT_EQ(parallel.getSize(), 80000);
+    string expected, result;
+    for (int i = 0; i < 80000; i += 97) {
+        ASSERT_TRUE(serial.get("key" + to_string(i), expected));
+        ASSERT_TRUE(parallel.get("key" + to_string(i), result));
+        EXPECT_EQ(result, expected);
+    }
+    EXPECT_TRUE(parallel.get("key5", result));
+    EXPECT_EQ(result, "value5"); // Остаётся первое вхождение ключа
+    EXPECT_TRUE(parallel.get("key1", result));
+    EXPECT_EQ(result, "existing");
+    EXPECT_TRUE(parallel.get("key7", result));
+    EXPECT_EQ(result, "value7;x");
+
+    // Длинные цепочки: корзины на границах отрезков потоков содержат
+    // записи двух потоков, часть из них вставляется отдельным проходом
+    HashTable chained(2, 1000.0);
+    chained.push("key1", "existing");
+    testing::internal::CaptureStdout();
+    chained.loadFromFile("parallel_test.txt", false, 4);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), serialOutput);
+    EXPECT_EQ(chained.getSize(), 80000);
+    for (int i = 0; i < 80000; i += 97) {
+        ASSERT_TRUE(serial.get("key" + to_string(i), expected));
+        ASSERT_TRUE(chained.get("key" + to_string(i), result));
+        EXPECT_EQ(result, expected);
+    }
+    EXPECT_TRUE(chained.get("key5", result));
+    EXPECT_EQ(result, "value5");
+    fs::remove("parallel_test.txt");
+}
+
+// Тест экранирования разделителей при сохранении и загрузке
+TEST(HashTableTest, EscapedTextExport) {
+    HashTable table;
+    table.push("key;with;separators", "value;1");
+    table.push("back\\slash", "multi\nline");
+    string large(100000, 'x'); // Большое поле уходит в файл через writev
+    table.push("large", large);
+    table.saveToFile("escape_test.txt");
+
+    HashTable loaded;
+    loaded.loadFromFile("escape_test.txt");
+    EXPECT_EQ(loaded.getSize(), 3);
+    string result;
+    EXPECT_TRUE(loaded.get("key;with;separators", result));
+    EXPECT_EQ(result, "value;1");
+    EXPECT_TRUE(loaded.get("back\\slash", result));
+    EXPECT_EQ(result, "multi\nline");
+    EXPECT_TRUE(loaded.get("large", result));
+    EXPECT_EQ(result, large);
+
+    FlatHashTable flat;
+    flat.loadFromFile("escape_test.txt");
+    EXPECT_TRUE(flat.get("key;with;separators", result));
+    EXPECT_EQ(result, "value;1");
+    fs::remove("escape_test.txt");
+}
+
+// Хеш-функция, считающая свои вызовы
+static size_t hashCalls = 0;
+static uint64_t countingHash(string_view key, uint64_t seed) {
+    ++hashCalls;
+    return fastHash(key, seed);
+}
+
+// Тест пользовательской хеш-функции: рост таблицы использует сохранённые хеши
+TEST(HashTableTest, CustomHashFunction) {
+    hashCalls = 0;
+    HashTable table(2, 1.0, 0.0, countingHash, 12345);
+    for (int i = 0; i < 1000; ++i) {
+        table.push("user:" + to_string(i), "value");
+    }
+    EXPECT_GT(table.getCapacity(), 2);
+    EXPECT_EQ(hashCalls, 1000); // По одному вызову на push, при росте хеши не пересчитываются
+    EXPECT_EQ(table.getHashSeed(), 12345);
+    string result;
+    EXPECT_TRUE(table.get("user:999", result));
+    EXPECT_FALSE(table.get("user:1000", result));
+}
+
+// Тест худшей хеш-функции: все ключи в одной корзине, поиск по-прежнему верен
+TEST(HashTableTest, CollidingHashFunction) {
+    HashTable table(10, 1.0, 0.0, [](string_view, uint64_t) -> uint64_t { return 42; });
+    for (int i = 0; i < 100; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    string result;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(table.get("key" + to_string(i), result));
+        EXPECT_EQ(result, "value" + to_string(i));
+    }
+    EXPECT_TRUE(table.del("key50"));
+    EXPECT_FALSE(table.get("key50", result));
+}
+
+// Тест хеш-функции по умолчанию: зависимость от зерна и от каждого байта
+TEST(HashTableTest, FastHashProperties) {
+    EXPECT_EQ(fastHash("user:000123"), fastHash("user:000123"));
+    EXPECT_NE(fastHash("user:000123", 1), fastHash("user:000123", 2));
+    EXPECT_NE(fastHash(""), fastHash(string_view("\0", 1)));
+    string longKey(100, 'x');
+    string other = longKey;
+    other[57] = 'y';
+    EXPECT_NE(fastHash(longKey), fastHash(other));
+    for (size_t n = 0; n < 40; ++n) { // Разные длины проходят через разные ветви
+        EXPECT_NE(fastHash(string(n, 'a')), fastHash(string(n + 1, 'a')));
+    }
+}
+
+// Тест: короткие ключи одной длины различаются при любом зерне,
+// в том числе нулевом
+TEST(HashTableTest, FastHashShortKeysWithSeed) {
+    for (uint64_t seed : {0ULL, 1ULL, 12345ULL}) {
+        EXPECT_NE(fastHash("a", seed), fastHash("b", seed));
+        EXPECT_NE(fastHash("a", seed), fastHash("q", seed));
+        EXPECT_NE(fastHash("zz", seed), fastHash("xy", seed));
+        EXPECT_NE(fastHash("abc", seed), fastHash("abd", seed));
+        set<uint64_t> hashes;
+        for (int c = 0; c < 256; ++c) {
+            hashes.insert(fastHash(string(1, static_cast<char>(c)), seed));
+        }
+        EXPECT_EQ(hashes.size(), 256);
+    }
+}
+
+// Тест пакетного поиска: найденные и отсутствующие ключи, малые пакеты
+TEST(HashTableTest, MultiGet) {
+    HashTable table;
+    table.setIncrementalRehash(true, 1); // Часть ключей может быть ещё в старом массиве
+    vector<string> keys;
+    for (int i = 0; i < 300; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    for (int i = 0; i < 400; i += 3) {
+        keys.push_back("key" + to_string(i));
+    }
+    vector<string_view> views(keys.begin(), keys.end());
+    vector<string_view> values(views.size());
+    unique_ptr<bool[]> found(new bool[views.size()]);
+    size_t total = table.multiGet(views.data(), views.size(), values.data(), found.get());
+    size_t expected = 0;
+    for (size_t i = 0; i < views.size(); ++i) {
+        int number = stoi(keys[i].substr(3));
+        EXPECT_EQ(found[i], number < 300);
+        if (number < 300) {
+            EXPECT_EQ(values[i], "value" + to_string(number));
+            ++expected;
+        }
+    }
+    EXPECT_EQ(total, expected);
+
+    string_view single[1] = {"key7"};
+    EXPECT_EQ(table.multiGet(single, 1, values.data(), found.get()), 1); // Пакет короче конвейера
+    EXPECT_EQ(values[0], "value7");
+    EXPECT_EQ(table.multiGet(single, 0, values.data(), found.get()), 0);
+}
+
+// Тест снимка, читаемого прямо из отображения файла в память
+TEST(HashTableTest, MappedSnapshot) {
+    HashTable table;
+    for (int i = 0; i < 1000; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    string longValue(500, 'x');
+    table.push("long", longValue);
+    ASSERT_TRUE(table.saveSnapshot("snapshot_test.bin"));
+
+    MappedHashTable mapped;
+    ASSERT_TRUE(mapped.open("snapshot_test.bin"));
+    EXPECT_EQ(mapped.getSize(), 1001);
+    string result;
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(mapped.get("key" + to_string(i), result));
+        EXPECT_EQ(result, "value" + to_string(i));
+    }
+    string_view view;
+    EXPECT_TRUE(mapped.get("long", view));
+    EXPECT_EQ(view, longValue);
+    EXPECT_FALSE(mapped.get("key1000", view));
+    mapped.close();
+    EXPECT_FALSE(mapped.isOpen());
+    fs::remove("snapshot_test.bin");
+}
+
+// Тест пустого снимка и файла другого формата
+TEST(HashTableTest, MappedSnapshotInvalid) {
+    HashTable empty;
+    ASSERT_TRUE(empty.saveSnapshot("snapshot_test.bin"));
+    MappedHashTable mapped;
+    ASSERT_TRUE(mapped.open("snapshot_test.bin"));
+    string result;
+    EXPECT_FALSE(mapped.get("key", result));
+    EXPECT_EQ(mapped.getSize(), 0);
+
+    empty.push("name", "John Doe");
+    empty.saveToBinaryFile("snapshot_test.bin"); // Обычный бинарный файл - не снимок
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(mapped.open("snapshot_test.bin"));
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "Error: invalid snapshot format.\n");
+    EXPECT_FALSE(mapped.get("name", result));
+    fs::remove("snapshot_test.bin");
+}
+
+// Тест: заголовок, смещения которого переполняют арифметику или не
+// выровнены, отклоняется при открытии
+TEST(HashTableTest, MappedSnapshotCraftedHeader) {
+    HashTable table;
+    for (int i = 0; i < 100; ++i) {
+        table.push("key" + to_string(i), "value");
+    }
+    table.enableBloomFilter();
+    ASSERT_TRUE(table.saveSnapshot("snapshot_test.bin"));
+    ifstream in("snapshot_test.bin", ios::binary);
+    string image((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    SnapshotHeader original;
+    memcpy(&original, image.data(), sizeof(original));
+
+    vector<SnapshotHeader> crafted(6, original);
+    crafted[0].entriesOffset = ~0ULL - 7; // entriesOffset + count * size переполняется
+    crafted[1].bucketsOffset = ~0ULL - 7;
+    crafted[2].bucketsOffset = 0; // корзины поверх заголовка
+    crafted[3].bucketsOffset = original.bucketsOffset + 1; // не выровнено
+    crafted[4].entriesOffset = original.entriesOffset + 4;
+    crafted[5].bloomOffset = ~0ULL - 63;
+    MappedHashTable mapped;
+    for (const SnapshotHeader& header : crafted) {
+        memcpy(&image[0], &header, sizeof(header));
+        ofstream("snapshot_test.bin", ios::binary).write(image.data(), image.size());
+        testing::internal::CaptureStderr();
+        EXPECT_FALSE(mapped.open("snapshot_test.bin"));
+        EXPECT_EQ(testing::internal::GetCapturedStderr(), "Error: invalid snapshot format.\n");
+    }
+    memcpy(&image[0], &original, sizeof(original));
+    ofstream("snapshot_test.bin", ios::binary).write(image.data(), image.size());
+    ASSERT_TRUE(mapped.open("snapshot_test.bin"));
+    string result;
+    EXPECT_TRUE(mapped.get("key42", result));
+    fs::remove("snapshot_test.bin");
+}
+
+// Тест фильтра Блума: ложных отрицаний нет, ложных срабатываний мало
+TEST(HashTableTest, BloomFilter) {
+    BloomFilter filter(10000);
+    for (uint64_t i = 0; i < 10000; ++i) {
+        filter.add(fastHash(to_string(i)));
+    }
+    size_t falsePositives = 0;
+    for (uint64_t i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(filter.mayContain(fastHash(to_string(i))));
+        falsePositives += filter.mayContain(fastHash("miss" + to_string(i)));
+    }
+    EXPECT_LT(falsePositives, 300); // около 1% при 10 битах на ключ
+}
+
+// Тест таблицы с фильтром: рост, удаления и перестройка фильтра
+TEST(HashTableTest, BloomFilterLookups) {
+    HashTable table;
+    table.push("before", "1"); // Ключи до включения фильтра тоже попадают в него
+    table.enableBloomFilter(16);
+    EXPECT_TRUE(table.hasBloomFilter());
+    for (int i = 0; i < 1000; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i)); // Фильтр растёт вместе с таблицей
+    }
+    string result;
+    EXPECT_TRUE(table.get("before", result));
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(table.get("key" + to_string(i), result));
+        EXPECT_EQ(result, "value" + to_string(i));
+        EXPECT_FALSE(table.get("miss" + to_string(i), result));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        EXPECT_TRUE(table.del("key" + to_string(i))); // Перестройка после множества удалений
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(table.get("key" + to_string(i), result), i % 2 == 1);
+    }
+    testing::internal::CaptureStdout();
+    table.push("key1", "again");
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "6:ERROR: Key already exists.\n");
+    table.rebuildBloomFilter();
+    table.disableBloomFilter();
+    EXPECT_FALSE(table.hasBloomFilter());
+    EXPECT_TRUE(table.get("key1", result));
+}
+
+// Тест снимка с фильтром Блума
+TEST(HashTableTest, MappedSnapshotBloomFilter) {
+    HashTable table;
+    table.enableBloomFilter();
+    for (int i = 0; i < 500; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    ASSERT_TRUE(table.saveSnapshot("snapshot_test.bin"));
+    MappedHashTable mapped;
+    ASSERT_TRUE(mapped.open("snapshot_test.bin"));
+    EXPECT_TRUE(mapped.hasBloomFilter());
+    string_view result;
+    for (int i = 0; i < 500; ++i) {
+        ASSERT_TRUE(mapped.get("key" + to_string(i), result));
+        EXPECT_EQ(result, "value" + to_string(i));
+        EXPECT_FALSE(mapped.get("miss" + to_string(i), result));
+    }
+    mapped.close();
+    fs::remove("snapshot_test.bin");
+}
+
+// Тест замороженной таблицы на минимальной совершенной хеш-функции
+TEST(HashTableTest, FrozenPerfectHash) {
+    HashTable table;
+    for (int i = 0; i < 5000; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    table.push("", "empty key");
+    FrozenHashTable frozen;
+    ASSERT_TRUE(frozen.build(table));
+    EXPECT_EQ(frozen.getSize(), 5001);
+    ASSERT_TRUE(frozen.saveToFile("frozen_test.bin"));
+
+    FrozenHashTable loaded;
+    ASSERT_TRUE(loaded.loadFromFile("frozen_test.bin"));
+    string_view result;
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_TRUE(loaded.get("key" + to_string(i), result));
+        EXPECT_EQ(result, "value" + to_string(i));
+        EXPECT_FALSE(loaded.get("miss" + to_string(i), result));
+    }
+    EXPECT_TRUE(loaded.get("", result));
+    EXPECT_EQ(result, "empty key");
+    EXPECT_EQ(loaded.getMemoryUsage(), frozen.getMemoryUsage());
+
+    HashTable empty;
+    FrozenHashTable frozenEmpty;
+    ASSERT_TRUE(frozenEmpty.build(empty));
+    EXPECT_FALSE(frozenEmpty.get("key", result));
+
+    table.saveToBinaryFile("frozen_test.bin"); // Не образ замороженной таблицы
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(loaded.loadFromFile("frozen_test.bin"));
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "Error: invalid frozen table format.\n");
+    EXPECT_FALSE(loaded.get("key1", result));
+
+    // Смещение массива записей, при котором сложение переполняется
+    ASSERT_TRUE(frozen.saveToFile("frozen_test.bin"));
+    ifstream in("frozen_test.bin", ios::binary);
+    string image((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    FrozenHeader header;
+    memcpy(&header, image.data(), sizeof(header));
+    header.entriesOffset = ~0ULL - 7;
+    memcpy(&image[0], &header, sizeof(header));
+    ofstream("frozen_test.bin", ios::binary).write(image.data(), image.size());
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(loaded.loadFromFile("frozen_test.bin"));
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "Error: invalid frozen table format.\n");
+    fs::remove("frozen_test.bin");
+}
+
+// Тест снимка с копированием при записи: снимок не видит последующих изменений
+TEST(HashTableTest, CopyOnWriteSnapshot) {
+    HashTable table;
+    for (int i = 0; i < 1000; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    size_t capacity = table.getCapacity();
+    unique_ptr<HashTable::Snapshot> snapshot = table.snapshot();
+    ASSERT_NE(snapshot, nullptr);
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(table.snapshot(), nullptr); // Одновременно жив только один снимок
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "Error: snapshot already exists.\n");
+
+    for (int i = 0; i < 1000; i += 2) {
+        EXPECT_TRUE(table.del("key" + to_string(i)));
+    }
+    for (int i = 1000; i < 3000; ++i) {
+        table.push("key" + to_string(i), "new");
+    }
+    EXPECT_EQ(table.getCapacity(), capacity); // Рехеш отложен, пока снимок жив
+    string result;
+    EXPECT_FALSE(table.get("key0", result));
+    EXPECT_TRUE(snapshot->get("key0", result));
+    EXPECT_EQ(result, "value0");
+    EXPECT_FALSE(snapshot->get("key1500", result));
+    EXPECT_EQ(snapshot->getSize(), 1000);
+    size_t visited = 0;
+    snapshot->forEachPair([&](string_view key, string_view value) {
+        EXPECT_EQ(value, "value" + string(key.substr(3)));
+        ++visited;
+    });
+    EXPECT_EQ(visited, 1000);
+
+    snapshot.reset();
+    table.push("after", "snapshot"); // Отложенный рост выполняется после освобождения снимка
+    EXPECT_GT(table.getCapacity(), capacity);
+    EXPECT_NE(table.snapshot(), nullptr);
+}
+
+// Тест фонового сохранения снимка во время изменений таблицы
+TEST(HashTableTest, BackgroundSnapshotSave) {
+    unique_ptr<HashTable> table(new HashTable());
+    for (int i = 0; i < 20000; ++i) {
+        table->push("key" + to_string(i), "value" + to_string(i));
+    }
+    unique_ptr<HashTable::Snapshot> snapshot = table->snapshot();
+    thread saver([&snapshot]() {
+        snapshot->saveToBinaryFile("cow_test.bin");
+    });
+    for (int i = 0; i < 20000; ++i) {
+        table->del("key" + to_string(i));
+        table->push("other" + to_string(i), "x");
+    }
+    saver.join();
+    table.reset(); // Снимок переживает таблицу
+    string result;
+    EXPECT_TRUE(snapshot->get("key19999", result));
+    EXPECT_EQ(result, "value19999");
+
+    HashTable loaded;
+    loaded.loadFromBinaryFile("cow_test.bin", true);
+    EXPECT_EQ(loaded.getSize(), 20000);
+    for (int i = 0; i < 20000; i += 101) {
+        ASSERT_TRUE(loaded.get("key" + to_string(i), result));
+        EXPECT_EQ(result, "value" + to_string(i));
+    }
+    EXPECT_FALSE(loaded.get("other0", result));
+    fs::remove("cow_test.bin");
+}
+
+// Тест курсора scan: рост, сжатие и постепенный перенос между вызовами
+// не дают ни пропусков, ни повторов исходных записей
+TEST(HashTableTest, ScanCursorAcrossResize) {
+    HashTable table(8, 1.0, 0.25);
+    table.setIncrementalRehash(true, 1);
+    for (int i = 0; i < 300; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    map<string, int> seen;
+    uint64_t cursor = 0;
+    int step = 0;
+    do {
+        cursor = table.scan(cursor, 7, [&](string_view key, string_view value) {
+            if (key.substr(0, 3) == "key") {
+                ++seen[string(key)];
+                EXPECT_EQ(value.substr(5), key.substr(3));
+            }
+        });
+        ++step;
+        if (step < 20) {
+            for (int i = 0; i < 100; ++i) {
+                table.push("extra" + to_string(step * 100 + i), "x"); // рост таблицы
+            }
+        } else if (step < 40) {
+            for (int i = 0; i < 100; ++i) {
+                table.del("extra" + to_string((step - 19) * 100 + i)); // сжатие
+            }
+        }
+    } while (cursor != 0);
+    EXPECT_EQ(seen.size(), 300);
+    for (const auto& entry : seen) {
+        EXPECT_EQ(entry.second, 1) << entry.first;
+    }
+}
+
+// Тест итератора: обход без копирования, вставки во время обхода допустимы
+TEST(HashTableTest, IteratorSurvivesGrowth) {
+    HashTable table(4);
+    table.setIncrementalRehash(true, 1);
+    for (int i = 0; i < 100; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    set<string> seen;
+    int added = 0;
+    for (auto entry : table) {
+        if (entry.first.substr(0, 3) == "key") {
+            EXPECT_TRUE(seen.insert(string(entry.first)).second);
+            EXPECT_EQ(entry.second.substr(5), entry.first.substr(3));
+        }
+        if (added < 1000) {
+            table.push("new" + to_string(added++), "v");
+        }
+    }
+    EXPECT_EQ(seen.size(), 100);
+    EXPECT_TRUE(HashTable().begin() == HashTable().end());
+}
+
+// Подменяемые часы для тестов сроков жизни
+static uint64_t fakeNow = 1000;
+
+static uint64_t fakeClock() {
+    return fakeNow;
+}
+
+// Тест итератора по таблице с TTL: push во время обхода удаляет
+// просроченные узлы текущего участка, но они освобождаются после обхода
+TEST(HashTableTest, IteratorWithExpiringEntries) {
+    fakeNow = 1000;
+    HashTable table(2, 1000.0); // Длинные цепочки: участок итератора - сотни узлов
+    table.setTimeSource(fakeClock);
+    for (int i = 0; i < 200; ++i) {
+        table.push("ttl" + to_string(i), "vttl" + to_string(i), 10);
+        table.push("key" + to_string(i), "vkey" + to_string(i));
+    }
+    set<string> seen;
+    int added = 0;
+    {
+        HashTable::Iterator copy = table.end();
+        for (auto it = table.begin(); it != table.end(); ++it) {
+            auto entry = *it;
+            EXPECT_EQ(entry.second, "v" + string(entry.first));
+            EXPECT_TRUE(seen.insert(string(entry.first)).second); // Узлы участка не переиспользованы
+            if (added == 0) {
+                fakeNow = 2000; // Все ttl-записи просрочены, в том числе уже прочитанные в участок
+                copy = it;
+            }
+            string key = "new" + to_string(added++);
+            table.push(key, "v" + key); // Колесо удаляет просроченные узлы
+        }
+        EXPECT_EQ(table.getSize(), 200 + added);
+    }
+    string result;
+    EXPECT_FALSE(table.get("ttl0", result));
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_EQ(seen.count("key" + to_string(i)), 1);
+    }
+    for (int i = 0; i < 300; ++i) {
+        table.push("after" + to_string(i), "x"); // Отложенные узлы вернулись в пул
+    }
+    EXPECT_EQ(table.getSize(), 500 + added);
+}
+
+// Тест: просроченный ключ не находится, а его место можно занять снова
+TEST(HashTableTest, TimeToLive) {
+    fakeNow = 1000;
+    HashTable table;
+    table.setTimeSource(fakeClock);
+    table.push("short", "1", 10);
+    table.push("long", "2", 5000);
+    table.push("forever", "3");
+    string result;
+    EXPECT_TRUE(table.get("short", result));
+    fakeNow = 1010;
+    EXPECT_FALSE(table.get("short", result));
+    EXPECT_TRUE(table.get("long", result));
+    testing::internal::CaptureStdout();
+    table.push("short", "4", 10); // старая запись просрочена и заменяется
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    EXPECT_TRUE(table.get("short", result));
+    EXPECT_EQ(result, "4");
+    EXPECT_EQ(table.getSize(), 3);
+}
+
+// Тест: снимок, заморозка и смена часов не оживляют просроченные записи
+TEST(HashTableTest, TimeToLiveExports) {
+    fakeNow = 1000;
+    HashTable table;
+    table.setTimeSource(fakeClock);
+    for (int i = 0; i < 10; ++i) {
+        table.push("short" + to_string(i), "1", 10);
+    }
+    table.push("long", "2", 5000);
+    table.push("forever", "3");
+    fakeNow = 1010;
+    ASSERT_TRUE(table.saveSnapshot("ttl_snapshot.bin"));
+    MappedHashTable mapped;
+    ASSERT_TRUE(mapped.open("ttl_snapshot.bin"));
+    EXPECT_EQ(mapped.getSize(), 2);
+    string result;
+    EXPECT_FALSE(mapped.get("short0", result));
+    EXPECT_TRUE(mapped.get("long", result));
+    fs::remove("ttl_snapshot.bin");
+
+    FrozenHashTable frozen;
+    ASSERT_TRUE(frozen.build(table));
+    EXPECT_EQ(frozen.getSize(), 2);
+    EXPECT_FALSE(frozen.get("short0", result));
+
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(table.setTimeSource(steadyMilliseconds)); // Есть сроки по старым часам
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "Error: table has entries with TTL.\n");
+    table.del("long");
+    EXPECT_TRUE(table.setTimeSource(steadyMilliseconds)); // Остались только бессрочные записи
+    EXPECT_EQ(table.getTimerCount(), 0);
+    EXPECT_TRUE(table.get("forever", result));
+}
+
+static size_t clockReads = 0;
+
+static uint64_t countingClock() {
+    ++clockReads;
+    return fakeNow;
+}
+
+// Тест: поиск, multiGet и обход таблицы без TTL не читают часы,
+// а сохранение читает их один раз
+TEST(HashTableTest, TimeToLiveClockReads) {
+    HashTable table;
+    table.setTimeSource(countingClock);
+    for (int i = 0; i < 100; ++i) {
+        table.push("key" + to_string(i), "value");
+    }
+    clockReads = 0;
+    string result;
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(table.get("key" + to_string(i % 100), result));
+    }
+    string_view keys[2] = {"key1", "key2"};
+    string_view values[2];
+    bool found[2];
+    EXPECT_EQ(table.multiGet(keys, 2, values, found), 2);
+    size_t visited = 0;
+    for (auto entry : table) {
+        visited += !entry.first.empty();
+    }
+    EXPECT_EQ(visited, 100);
+    EXPECT_EQ(clockReads, 0);
+
+    table.saveToFile("clock_reads.txt");
+    table.saveToBinaryFile("clock_reads.bin");
+    EXPECT_EQ(clockReads, 2);
+    fs::remove("clock_reads.txt");
+    fs::remove("clock_reads.bin");
+}
+
+// Тест: снимок с копированием при записи не видит записей, просроченных
+// к моменту снимка, в том числе в скопированных корзинах
+TEST(HashTableTest, TimeToLiveSnapshot) {
+    fakeNow = 1000;
+    HashTable table;
+    table.setTimeSource(fakeClock);
+    table.push("sess", "v", 1000);
+    table.push("tok", "t", 5000);
+    table.push("user", "u");
+    fakeNow = 2000; // sess просрочен, но ещё не удалён
+    unique_ptr<HashTable::Snapshot> snapshot = table.snapshot();
+    ASSERT_NE(snapshot, nullptr);
+    string result;
+    EXPECT_FALSE(table.get("sess", result));
+    EXPECT_FALSE(snapshot->get("sess", result));
+    EXPECT_EQ(snapshot->getSize(), 2);
+
+    EXPECT_FALSE(table.del("sess")); // колесо удаляет sess, его корзина копируется
+    fakeNow = 10000; // время снимка не меняется: tok в нём жив
+    table.expire();
+    EXPECT_FALSE(snapshot->get("sess", result));
+    EXPECT_TRUE(snapshot->get("tok", result));
+    EXPECT_EQ(result, "t");
+    size_t visited = 0;
+    snapshot->forEachPair([&](string_view, string_view) {
+        ++visited;
+    });
+    EXPECT_EQ(visited, 2);
+
+    snapshot->saveToFile("ttl_cow.txt");
+    ifstream file("ttl_cow.txt");
+    string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    EXPECT_EQ(content.find("sess"), string::npos);
+    EXPECT_NE(content.find("tok;t\n"), string::npos);
+    EXPECT_NE(content.find("user;u\n"), string::npos);
+    fs::remove("ttl_cow.txt");
+}
+
+// Тест: колесо таймеров удаляет просроченные записи, в том числе
+// со сроками на верхних уровнях, и не трогает перезаписанные ключи
+TEST(HashTableTest, TimerWheelExpiry) {
+    fakeNow = 0;
+    HashTable table;
+    table.setTimeSource(fakeClock);
+    for (int i = 0; i < 1000; ++i) {
+        table.push("key" + to_string(i), "value", 1 + i * 997); // до ~16 минут
+    }
+    EXPECT_EQ(table.getTimerCount(), 1000);
+    table.del("key0");
+    table.push("key0", "value", 100000000); // ранний таймер прежней записи устарел
+    size_t expected = 0;
+    for (uint64_t step = 0; step <= 1000000; step += 12345) {
+        fakeNow = step;
+        expected = 0;
+        for (int i = 1; i < 1000; ++i) {
+            expected += 1 + static_cast<uint64_t>(i) * 997 > step;
+        }
+        table.expire();
+        EXPECT_EQ(table.getSize(), expected + 1);
+    }
+    string result;
+    EXPECT_TRUE(table.get("key0", result));
+    EXPECT_EQ(table.getTimerCount(), 1);
+
+    TimerWheel wheel(0);
+    wheel.schedule(1, 64 * 64 * 64 * 64 * 3ULL); // дальше верхнего уровня
+    size_t fired = 0;
+    wheel.advance(64 * 64 * 64 * 64 * 3ULL - 1, [&](const TimerWheel::Timer&) { ++fired; });
+    EXPECT_EQ(fired, 0);
+    wheel.advance(64 * 64 * 64 * 64 * 3ULL, [&](const TimerWheel::Timer& timer) { fired += timer.id; });
+    EXPECT_EQ(fired, 1);
+}
+
+// Тесты для хеш-таблицы с открытой адресацией ---------------------------------------------------------------------------
+
+// Тест добавления, поиска и удаления
+TEST(FlatHashTableTest, PushGetDelete) {
+    FlatHashTable table;
+    table.push("key1", "value1");
+    testing::internal::CaptureStdout();
+    table.push("key1", "value2"); // Попытка добавить элемент с существующим ключом
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "6:ERROR: Key already exists.\n");
+    string result;
+    EXPECT_TRUE(table.get("key1", result));
+    EXPECT_EQ(result, "value1");
+    EXPECT_TRUE(table.del("key1"));
+    EXPECT_FALSE(table.del("key1"));
+    EXPECT_FALSE(table.get("key1", result));
+    EXPECT_EQ(table.getSize(), 0);
+}
+
+// Тест роста и повторного использования удалённых слотов
+TEST(FlatHashTableTest, LargeNumberOfOperations) {
+    FlatHashTable table;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 2000; ++i) {
+            table.push("key" + to_string(i), "value" + to_string(i));
+        }
+        for (int i = 0; i < 2000; i += 2) {
+            EXPECT_TRUE(table.del("key" + to_string(i)));
+        }
+        for (int i = 0; i < 2000; ++i) {
+            string result;
+            EXPECT_EQ(table.get("key" + to_string(i), result), i % 2 == 1);
+        }
+        for (int i = 1; i < 2000; i += 2) {
+            EXPECT_TRUE(table.del("key" + to_string(i)));
+        }
+    }
+    EXPECT_EQ(table.getSize(), 0);
+    EXPECT_LE(table.getCapacity(), 8192); // Надгробия не раздувают таблицу бесконечно
+}
+
+// Тест поиска без копирования
+TEST(FlatHashTableTest, StringViewLookup) {
+    FlatHashTable table;
+    table.push("user:1", "value");
+    string_view value;
+    EXPECT_TRUE(table.get(string_view("user:1;tail", 6), value));
+    EXPECT_EQ(value, "value");
+    EXPECT_FALSE(table.get(string_view("user:1", 5), value));
+}
+
+// Тест совместимости файлов с HashTable
+TEST(FlatHashTableTest, FilesCompatibleWithHashTable) {
+    HashTable chained;
+    chained.push("name", "John Doe");
+    chained.push("city", "Novosibirsk");
+    chained.saveToBinaryFile("flat_test.bin");
+    chained.saveToFile("flat_test.txt");
+
+    FlatHashTable fromBinary;
+    fromBinary.loadFromBinaryFile("flat_test.bin");
+    FlatHashTable fromText;
+    fromText.loadFromFile("flat_test.txt");
+    string result;
+    EXPECT_TRUE(fromBinary.get("city", result));
+    EXPECT_EQ(result, "Novosibirsk");
+    EXPECT_TRUE(fromText.get("name", result));
+    EXPECT_EQ(result, "John Doe");
+
+    fromText.saveToBinaryFile("flat_test.bin");
+    HashTable back;
+    back.loadFromBinaryFile("flat_test.bin");
+    EXPECT_TRUE(back.get("city", result));
+    EXPECT_EQ(back.getSize(), 2);
+    fs::remove("flat_test.bin");
+    fs::remove("flat_test.txt");
+}
+
+// Тесты для потокобезопасной хеш-таблицы ---------------------------------------------------------------------------------
+
+// Тест параллельных вставок, чтений и удалений из нескольких потоков
+TEST(ConcurrentHashTableTest, ParallelOperations) {
+    ConcurrentHashTable table(16);
+    vector<thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&table, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                table.push("t" + to_string(t) + ":" + to_string(i), to_string(i));
+            }
+            for (int i = 0; i < 1000; i += 2) {
+                table.del("t" + to_string(t) + ":" + to_string(i));
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(table.getSize(), 2000);
+    string result;
+    EXPECT_TRUE(table.get("t3:999", result));
+    EXPECT_EQ(result, "999");
+    EXPECT_FALSE(table.get("t3:998", result));
+    EXPECT_EQ(table.getStripeCount(), 16);
+}
+
+// Тест сохранения и загрузки через все полосы
+TEST(ConcurrentHashTableTest, SaveAndLoad) {
+    ConcurrentHashTable table(4);
+    for (int i = 0; i < 100; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    table.saveToBinaryFile("concurrent_test.bin");
+    table.saveToFile("concurrent_test.txt");
+
+    ConcurrentHashTable fromBinary(8);
+    fromBinary.loadFromBinaryFile("concurrent_test.bin");
+    HashTable fromText;
+    fromText.loadFromFile("concurrent_test.txt");
+    EXPECT_EQ(fromBinary.getSize(), 100);
+    EXPECT_EQ(fromText.getSize(), 100);
+    string result;
+    EXPECT_TRUE(fromBinary.get("key42", result));
+    EXPECT_EQ(result, "value42");
+    fs::remove("concurrent_test.bin");
+    fs::remove("concurrent_test.txt");
+}
+
+// Тесты для хеш-таблицы с чтением без блокировок -------------------------------------------------------------------------
+
+// Тест базовых операций и роста
+TEST(LockFreeReadHashTableTest, PushGetDelete) {
+    LockFreeReadHashTable table(4);
+    for (int i = 0; i < 1000; ++i) {
+        table.push("key" + to_string(i), "value" + to_string(i));
+    }
+    EXPECT_GE(table.getCapacity(), 1000); // Таблица выросла
+    string result;
+    EXPECT_TRUE(table.get("key500", result));
+    EXPECT_EQ(result, "value500");
+    testing::internal::CaptureStdout();
+    table.push("key500", "other");
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "6:ERROR: Key already exists.\n");
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(table.del("key" + to_string(i)));
+    }
+    EXPECT_FALSE(table.get("key500", result));
+    EXPECT_EQ(table.getSize(), 0);
+    EXPECT_LT(table.getRetiredCount(), 1000); // Без активных читателей узлы освобождаются
+}
+
+// Тест чтений, идущих параллельно с удалениями и ростом таблицы
+TEST(LockFreeReadHashTableTest, ReadersDuringWrites) {
+    LockFreeReadHashTable table;
+    for (int i = 0; i < 100; ++i) {
+        table.push("stable" + to_string(i), "value" + to_string(i));
+    }
+    atomic<bool> stop(false);
+    atomic<int> errors(0);
+    vector<thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&]() {
+            string result;
+            while (!stop.load()) {
+                for (int i = 0; i < 100; ++i) {
+                    if (!table.get("stable" + to_string(i), result) || result != "value" + to_string(i)) {
+                        ++errors;
+                    }
+                    table.get("temp" + to_string(i), result);
+                }
+            }
+        });
+    }
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 500; ++i) {
+            table.push("temp" + to_string(i), "x");
+        }
+        for (int i = 0; i < 500; ++i) {
+            table.del("temp" + to_string(i));
+        }
+    }
+    stop.store(true);
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(errors.load(), 0); // Постоянные ключи видны всегда
+    EXPECT_EQ(table.getSize(), 100);
+}
+
+// Тесты для LRU-кэша -----------------------------------------------------------------------------------------------------
+
+// Тест вытеснения давно не использованных записей по бюджету
+TEST(LRUCacheTest, EvictsLeastRecentlyUsed) {
+    LRUCache cache(30); // ключ и значение по 5 байт - три записи
+    EXPECT_TRUE(cache.put("key01", "val01"));
+    EXPECT_TRUE(cache.put("key02", "val02"));
+    EXPECT_TRUE(cache.put("key03", "val03"));
+    string result;
+    EXPECT_TRUE(cache.get("key01", result)); // key01 становится самым свежим
+    EXPECT_TRUE(cache.put("key04", "val04")); // вытесняется key02
+    EXPECT_FALSE(cache.contains("key02"));
+    EXPECT_TRUE(cache.contains("key01"));
+    EXPECT_EQ(cache.getSize(), 3);
+    EXPECT_EQ(cache.getUsedBytes(), 30);
+    EXPECT_EQ(cache.getEvictions(), 1);
+
+    EXPECT_TRUE(cache.put("key03", "a much longer value")); // Замена значения вытесняет старые записи
+    EXPECT_TRUE(cache.get("key03", result));
+    EXPECT_EQ(result, "a much longer value");
+    EXPECT_EQ(cache.getSize(), 1);
+    EXPECT_FALSE(cache.put("huge", string(100, 'x'))); // Больше всего бюджета
+    EXPECT_FALSE(cache.contains("huge"));
+    EXPECT_LE(cache.getUsedBytes(), cache.getByteBudget());
+}
+
+// Тест счётчиков, удаления и смены бюджета
+TEST(LRUCacheTest, CountersAndBudget) {
+    LRUCache cache(1 << 20);
+    for (int i = 0; i < 1000; ++i) {
+        cache.put("key" + to_string(i), string(100, 'v'));
+    }
+    string_view result;
+    for (int i = 0; i < 1000; i += 2) {
+        EXPECT_TRUE(cache.get("key" + to_string(i), result));
+        EXPECT_FALSE(cache.get("miss" + to_string(i), result));
+    }
+    EXPECT_EQ(cache.getHits(), 500);
+    EXPECT_EQ(cache.getMisses(), 500);
+    EXPECT_TRUE(cache.del("key0"));
+    EXPECT_FALSE(cache.del("key0"));
+
+    cache.setByteBudget(200 * 106); // Остаются самые свежие - чётные ключи key600..key998
+    EXPECT_EQ(cache.getSize(), 200);
+    EXPECT_EQ(cache.getEvictions(), 799);
+    for (int i = 998; i >= 600; i -= 2) {
+        EXPECT_TRUE(cache.contains("key" + to_string(i)));
+    }
+    cache.resetStats();
+    EXPECT_EQ(cache.getHits() + cache.getMisses() + cache.getEvictions(), 0);
+}
+
+// Тесты для хеш-таблицы с журналом -------------------------------------------------------------------------------------
+
+static void removeDurableFiles(const string& base) {
+    for (const char* suffix : {".snap", ".wal", ".wal.old", ".snap.tmp"}) {
+        fs::remove(base + suffix);
+    }
+}
+
+// Тест восстановления из журнала, в том числе с оборванной последней записью
+TEST(DurableHashTableTest, RecoverFromLog) {
+    removeDurableFiles("durable_test");
+    {
+        DurableHashTable table;
+        ASSERT_TRUE(table.open("durable_test"));
+        EXPECT_TRUE(table.push("name", "John Doe"));
+        EXPECT_TRUE(table.push("city", "Novosibirsk"));
+        EXPECT_TRUE(table.del("name"));
+        EXPECT_FALSE(table.del("name"));
+    }
+    {
+        ofstream log("durable_test.wal", ios::binary | ios::app);
+        log << "P\x05garbage"; // Запись, оборванная при сбое
+    }
+    DurableHashTable table;
+    ASSERT_TRUE(table.open("durable_test"));
+    string result;
+    EXPECT_FALSE(table.get("name", result));
+    EXPECT_TRUE(table.get("city", result));
+    EXPECT_EQ(result, "Novosibirsk");
+    EXPECT_TRUE(table.push("name", "Jane")); // Хвост журнала обрезан, дозапись продолжается
+    table.close();
+    ASSERT_TRUE(table.open("durable_test"));
+    EXPECT_TRUE(table.get("name", result));
+    EXPECT_EQ(result, "Jane");
+    EXPECT_EQ(table.getSize(), 2);
+    table.close();
+    removeDurableFiles("durable_test");
+}
+
+// Тест групповой фиксации из нескольких потоков и свёртки журнала в снимок
+TEST(DurableHashTableTest, GroupCommitAndCompaction) {
+    removeDurableFiles("durable_test");
+    DurableHashTable table;
+    ASSERT_TRUE(table.open("durable_test"));
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&table, t]() {
+            for (int i = 0; i < 50; ++i) {
+                EXPECT_TRUE(table.push("key" + to_string(t) + "_" + to_string(i), "value"));
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    EXPECT_EQ(table.getSize(), 200);
+    EXPECT_LE(table.getSyncCount(), 200); // Не больше одного fsync на изменение
+    EXPECT_GT(table.getLogSize(), 0);
+
+    EXPECT_TRUE(table.compact());
+    EXPECT_EQ(table.getLogSize(), 0);
+    EXPECT_FALSE(fs::exists("durable_test.wal.old"));
+    table.setCompactionThreshold(256); // Дальше свёртка запускается в фоне
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(table.del("key0_" + to_string(i % 50)) || i >= 50);
+    }
+    table.waitForCompaction();
+    table.close();
+
+    ASSERT_TRUE(table.open("durable_test"));
+    EXPECT_EQ(table.getSize(), 150);
+    string result;
+    EXPECT_FALSE(table.get("key0_7", result));
+    EXPECT_TRUE(table.get("key3_49", result));
+    table.close();
+    removeDurableFiles("durable_test");
+}
+
+// Тест неудачной свёртки: повторная свёртка не затирает несвёрнутый журнал
+TEST(DurableHashTableTest, FailedCompactionKeepsOldLog) {
+    removeDurableFiles("durable_test");
+    DurableHashTable table;
+    ASSERT_TRUE(table.open("durable_test"));
+    fs::create_directory("durable_test.snap.tmp"); // Снимок не удастся записать
+    EXPECT_TRUE(table.push("first", "1"));
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(table.compact());
+    EXPECT_TRUE(fs::exists("durable_test.wal.old"));
+    EXPECT_TRUE(table.push("second", "2"));
+    EXPECT_FALSE(table.compact());
+    testing::internal::GetCapturedStderr();
+    table.close(); // Как сбой: снимка нет, есть только журналы
+    fs::remove_all("durable_test.snap.tmp");
+    ASSERT_TRUE(table.open("durable_test"));
+    string result;
+    EXPECT_TRUE(table.get("first", result));
+    EXPECT_TRUE(table.get("second", result));
+    EXPECT_FALSE(fs::exists("durable_test.wal.old"));
+    EXPECT_TRUE(table.compact());
+    table.close();
+    removeDurableFiles("durable_test");
+}
+
 // Тесты для двусвязного списка -------------------------------------------------------------------------------------------
 
 // Тест создания двусвязного списка